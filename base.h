@@ -175,6 +175,7 @@ typedef uint8 evx_status;
 #define EVX_ERROR_NOT_READY                         (15)
 #define EVX_ERROR_OPERATION_COMPLETED               (16)
 #define EVX_ERROR_RESOURCE_UNUSED                   (17)
+#define EVX_ERROR_NEED_MORE_INPUT                   (18)
 
 /**********************************************************************************
 //
@@ -0,0 +1,455 @@
+
+#include "batch_cabac.h"
+
+#if defined (_M_X64) || defined (_M_IX86) || defined (__x86_64__) || defined (__i386__)
+    #define EVX_BATCH_X86
+    #include "immintrin.h"
+
+    #if defined (EVX_PLATFORM_WINDOWS)
+        #include "intrin.h"
+        #define EVX_TARGET_AVX2
+        #define EVX_TARGET_AVX512
+    #else
+        #define EVX_TARGET_AVX2             __attribute__((target("avx2")))
+        #define EVX_TARGET_AVX512           __attribute__((target("avx512f")))
+    #endif
+#endif
+
+#define EVX_BATCH_BLOCK_BITS                (32)
+#define EVX_BATCH_SIGN_BIT                  (0x80000000)
+
+/*
+// Batch Groups
+//
+// A group holds the state of up to EVX_BATCH_LANES_MAX streams in structure of
+// arrays form so that the kernels can load each field straight into a vector.
+// Decoding proceeds in blocks of up to 32 bins per lane; limit holds the bins 
+// each lane decodes in the current block, bits collects its output and 
+// bits_in receives the bytes gathered for a refill. Lanes beyond the number 
+// of streams in the group have a limit of zero throughout.
+*/
+
+typedef struct
+{
+    uint32 range[EVX_BATCH_LANES_MAX];
+    uint32 low[EVX_BATCH_LANES_MAX];
+    uint32 value[EVX_BATCH_LANES_MAX];
+    uint32 model[EVX_BATCH_LANES_MAX];
+    uint32 bits[EVX_BATCH_LANES_MAX];
+    uint32 limit[EVX_BATCH_LANES_MAX];
+    uint32 bits_in[EVX_BATCH_LANES_MAX];
+    uint64 remaining[EVX_BATCH_LANES_MAX];
+
+    entropy_coder_t coders[EVX_BATCH_LANES_MAX];
+    bitstream_reader_t readers[EVX_BATCH_LANES_MAX];
+    bitstream_writer_t writers[EVX_BATCH_LANES_MAX];
+
+    uint32 width;
+    uint32 lane_count;
+    uint8 adaptive;
+    uint8 rate;
+} evx_batch_group_t;
+
+static void evx_batch_open(evx_batch_group_t *group, const entropy_coder_t* prototype, uint32 width, 
+                           const uint64 *symbol_counts, bitstream_t *sources, bitstream_t *dests, uint32 lane_count)
+{
+    group->width = width;
+    group->lane_count = lane_count;
+    group->adaptive = prototype->adaptive;
+    group->rate = prototype->rate;
+
+    for (uint32 i = 0; i < width; ++i)
+    {
+        group->coders[i] = *prototype;
+        entropy_coder_clear(&group->coders[i]);
+
+        group->range[i] = group->coders[i].range;
+        group->low[i] = 0;
+        group->value[i] = 0;
+        group->remaining[i] = 0;
+        group->model[i] = (EVX_ENTROPY_MODEL_SHIFT == prototype->adaptive) ? group->coders[i].model 
+                                                                             : entropy_coder_query_probability(&group->coders[i]);
+        if (i >= lane_count)
+        {
+            continue;
+        }
+
+        group->remaining[i] = symbol_counts[i];
+        bitstream_reader_attach(&group->readers[i], &sources[i]);
+        bitstream_writer_attach(&group->writers[i], &dests[i]);
+
+        /* The first byte is always zero and falls off the top of value. */
+        for (uint32 j = 0; j < EVX_RANGE_FLUSH_BYTES; ++j)
+        {
+            group->value[i] = (group->value[i] << 8) | bitstream_reader_peek(&group->readers[i], 8);
+            bitstream_reader_consume(&group->readers[i], 8);
+        }
+    }
+}
+
+static evx_status evx_batch_close(evx_batch_group_t *group)
+{
+    evx_status result = EVX_SUCCESS;
+
+    for (uint32 i = 0; i < group->lane_count; ++i)
+    {
+        bitstream_reader_detach(&group->readers[i]);
+
+        if (EVX_SUCCESS != bitstream_writer_detach(&group->writers[i]))
+        {
+            result = EVX_ERROR_CAPACITY_LIMIT;
+        }
+    }
+
+    return result;
+}
+
+static uint32 evx_batch_begin_block(evx_batch_group_t *group)
+{
+    uint32 steps = 0;
+
+    for (uint32 i = 0; i < group->width; ++i)
+    {
+        group->limit[i] = (uint32) evx_min2(group->remaining[i], EVX_BATCH_BLOCK_BITS);
+        group->bits[i] = 0;
+        steps = evx_max2(steps, group->limit[i]);
+    }
+
+    return steps;
+}
+
+static evx_status evx_batch_end_block(evx_batch_group_t *group)
+{
+    for (uint32 i = 0; i < group->lane_count; ++i)
+    {
+        if (!group->limit[i])
+        {
+            continue;
+        }
+
+        if (EVX_SUCCESS != bitstream_writer_put_bits(&group->writers[i], group->bits[i], (uint8) group->limit[i]))
+        {
+            return EVX_ERROR_CAPACITY_LIMIT;
+        }
+
+        group->remaining[i] -= group->limit[i];
+    }
+
+    return EVX_SUCCESS;
+}
+
+static void evx_batch_refill(evx_batch_group_t *group, uint32 lane)
+{
+    do
+    {
+        group->range[lane] <<= 8;
+        group->low[lane] <<= 8;
+        group->value[lane] = (group->value[lane] << 8) | bitstream_reader_peek(&group->readers[lane], 8);
+        bitstream_reader_consume(&group->readers[lane], 8);
+    } while (group->range[lane] < EVX_RANGE_TOP);
+}
+
+static const uint32 *evx_batch_fetch(evx_batch_group_t *group, uint32 lane_mask)
+{
+    /* Gathers the next input byte of every lane in the mask. Other lanes 
+       receive zero so the result can be or'd into value directly. */
+    for (uint32 lane = 0; lane < group->width; ++lane, lane_mask >>= 1)
+    {
+        group->bits_in[lane] = 0;
+
+        if (lane_mask & 0x1)
+        {
+            group->bits_in[lane] = bitstream_reader_peek(&group->readers[lane], 8);
+            bitstream_reader_consume(&group->readers[lane], 8);
+        }
+    }
+
+    return group->bits_in;
+}
+
+static void evx_batch_run_scalar(evx_batch_group_t *group, uint32 steps)
+{
+    for (uint32 j = 0; j < steps; ++j)
+    {
+        for (uint32 i = 0; i < group->width; ++i)
+        {
+            if (j >= group->limit[i])
+            {
+                continue;
+            }
+
+            uint32 probability = group->model[i];
+            uint32 mid = (group->range[i] >> EVX_ENTROPY_PROBABILITY_BITS) * probability;
+            uint8 bit = (group->value[i] - group->low[i]) >= mid;
+
+            if (bit)
+            {
+                group->low[i] += mid;
+                group->range[i] -= mid;
+            }
+            else
+            {
+                group->range[i] = mid;
+            }
+
+            group->bits[i] |= (uint32) bit << j;
+
+            if (EVX_ENTROPY_MODEL_SHIFT == group->adaptive)
+            {
+                group->model[i] = bit ? probability - (probability >> group->rate) 
+                                      : probability + ((EVX_ENTROPY_PROBABILITY_ONE - probability) >> group->rate);
+            }
+            else if (EVX_ENTROPY_MODEL_COUNT == group->adaptive)
+            {
+                entropy_coder_update_model(&group->coders[i], bit);
+                group->model[i] = entropy_coder_query_probability(&group->coders[i]);
+            }
+
+            if (group->range[i] < EVX_RANGE_TOP)
+            {
+                evx_batch_refill(group, i);
+            }
+        }
+    }
+}
+
+#if defined (EVX_BATCH_X86)
+
+EVX_TARGET_AVX2 static void evx_batch_run_avx2(evx_batch_group_t *group, uint32 steps)
+{
+    const __m256i sign = _mm256_set1_epi32(EVX_BATCH_SIGN_BIT);
+    const __m256i top = _mm256_set1_epi32(EVX_RANGE_TOP ^ EVX_BATCH_SIGN_BIT);
+    const __m256i one = _mm256_set1_epi32(EVX_ENTROPY_PROBABILITY_ONE);
+    const __m128i rate = _mm_cvtsi32_si128(group->rate);
+    const __m256i limit = _mm256_loadu_si256((const __m256i *) group->limit);
+
+    __m256i range = _mm256_loadu_si256((const __m256i *) group->range);
+    __m256i low = _mm256_loadu_si256((const __m256i *) group->low);
+    __m256i value = _mm256_loadu_si256((const __m256i *) group->value);
+    __m256i model = _mm256_loadu_si256((const __m256i *) group->model);
+    __m256i bits = _mm256_setzero_si256();
+
+    for (uint32 j = 0; j < steps; ++j)
+    {
+        /* There is no unsigned compare, so bias both sides by the sign bit. */
+        __m256i active = _mm256_cmpgt_epi32(limit, _mm256_set1_epi32(j));
+        __m256i mid = _mm256_mullo_epi32(_mm256_srli_epi32(range, EVX_ENTROPY_PROBABILITY_BITS), model);
+        __m256i diff = _mm256_sub_epi32(value, low);
+        __m256i zero = _mm256_cmpgt_epi32(_mm256_xor_si256(mid, sign), _mm256_xor_si256(diff, sign));
+
+        low = _mm256_add_epi32(low, _mm256_andnot_si256(zero, mid));
+        range = _mm256_blendv_epi8(_mm256_sub_epi32(range, mid), mid, zero);
+        bits = _mm256_or_si256(bits, _mm256_andnot_si256(zero, _mm256_set1_epi32(1u << j)));
+
+        if (EVX_ENTROPY_MODEL_SHIFT == group->adaptive)
+        {
+            __m256i up = _mm256_add_epi32(model, _mm256_srl_epi32(_mm256_sub_epi32(one, model), rate));
+            __m256i down = _mm256_sub_epi32(model, _mm256_srl_epi32(model, rate));
+            model = _mm256_blendv_epi8(down, up, zero);
+        }
+
+        __m256i refill = _mm256_and_si256(active, _mm256_cmpgt_epi32(top, _mm256_xor_si256(range, sign)));
+        uint32 lane_mask = (uint32) _mm256_movemask_ps(_mm256_castsi256_ps(refill));
+
+        while (lane_mask)
+        {
+            /* Only the byte fetch is per lane; the shifts stay in registers. */
+            __m256i shift = _mm256_and_si256(refill, _mm256_set1_epi32(8));
+            __m256i input = _mm256_loadu_si256((const __m256i *) evx_batch_fetch(group, lane_mask));
+
+            range = _mm256_sllv_epi32(range, shift);
+            low = _mm256_sllv_epi32(low, shift);
+            value = _mm256_or_si256(_mm256_sllv_epi32(value, shift), input);
+
+            refill = _mm256_and_si256(refill, _mm256_cmpgt_epi32(top, _mm256_xor_si256(range, sign)));
+            lane_mask = (uint32) _mm256_movemask_ps(_mm256_castsi256_ps(refill));
+        }
+    }
+
+    _mm256_storeu_si256((__m256i *) group->range, range);
+    _mm256_storeu_si256((__m256i *) group->low, low);
+    _mm256_storeu_si256((__m256i *) group->value, value);
+    _mm256_storeu_si256((__m256i *) group->model, model);
+    _mm256_storeu_si256((__m256i *) group->bits, bits);
+}
+
+EVX_TARGET_AVX512 static void evx_batch_run_avx512(evx_batch_group_t *group, uint32 steps)
+{
+    const __m512i top = _mm512_set1_epi32(EVX_RANGE_TOP);
+    const __m512i one = _mm512_set1_epi32(EVX_ENTROPY_PROBABILITY_ONE);
+    const __m128i rate = _mm_cvtsi32_si128(group->rate);
+    const __m512i limit = _mm512_loadu_si512(group->limit);
+
+    __m512i range = _mm512_loadu_si512(group->range);
+    __m512i low = _mm512_loadu_si512(group->low);
+    __m512i value = _mm512_loadu_si512(group->value);
+    __m512i model = _mm512_loadu_si512(group->model);
+    __m512i bits = _mm512_setzero_si512();
+
+    for (uint32 j = 0; j < steps; ++j)
+    {
+        __mmask16 active = _mm512_cmpgt_epu32_mask(limit, _mm512_set1_epi32(j));
+        __m512i mid = _mm512_mullo_epi32(_mm512_srli_epi32(range, EVX_ENTROPY_PROBABILITY_BITS), model);
+        __mmask16 zero = _mm512_cmplt_epu32_mask(_mm512_sub_epi32(value, low), mid);
+        __mmask16 set = (__mmask16) ~zero;
+
+        low = _mm512_mask_add_epi32(low, set, low, mid);
+        range = _mm512_mask_blend_epi32(zero, _mm512_sub_epi32(range, mid), mid);
+        bits = _mm512_mask_or_epi32(bits, set, bits, _mm512_set1_epi32(1u << j));
+
+        if (EVX_ENTROPY_MODEL_SHIFT == group->adaptive)
+        {
+            __m512i up = _mm512_add_epi32(model, _mm512_srl_epi32(_mm512_sub_epi32(one, model), rate));
+            __m512i down = _mm512_sub_epi32(model, _mm512_srl_epi32(model, rate));
+            model = _mm512_mask_blend_epi32(zero, down, up);
+        }
+
+        uint32 lane_mask = (uint32) _mm512_mask_cmplt_epu32_mask(active, range, top);
+
+        while (lane_mask)
+        {
+            __m512i input = _mm512_loadu_si512(evx_batch_fetch(group, lane_mask));
+
+            range = _mm512_mask_slli_epi32(range, (__mmask16) lane_mask, range, 8);
+            low = _mm512_mask_slli_epi32(low, (__mmask16) lane_mask, low, 8);
+            value = _mm512_or_si512(_mm512_mask_slli_epi32(value, (__mmask16) lane_mask, value, 8), input);
+
+            lane_mask = (uint32) _mm512_mask_cmplt_epu32_mask((__mmask16) lane_mask, range, top);
+        }
+    }
+
+    _mm512_storeu_si512(group->range, range);
+    _mm512_storeu_si512(group->low, low);
+    _mm512_storeu_si512(group->value, value);
+    _mm512_storeu_si512(group->model, model);
+    _mm512_storeu_si512(group->bits, bits);
+}
+
+static uint8 evx_batch_query_cpu_kernel()
+{
+#if defined (EVX_PLATFORM_WINDOWS)
+    int info[4] = {0};
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+    {
+        return EVX_BATCH_KERNEL_SCALAR;
+    }
+
+    __cpuid(info, 1);
+
+    /* The OS must save the wider registers (OSXSAVE, then XCR0). */
+    if (!(info[2] & (1 << 27)))
+    {
+        return EVX_BATCH_KERNEL_SCALAR;
+    }
+
+    uint64 xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+
+    if ((info[1] & (1 << 16)) && 0xE6 == (xcr0 & 0xE6))
+    {
+        return EVX_BATCH_KERNEL_AVX512;
+    }
+
+    if ((info[1] & (1 << 5)) && 0x6 == (xcr0 & 0x6))
+    {
+        return EVX_BATCH_KERNEL_AVX2;
+    }
+#else
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+    {
+        return EVX_BATCH_KERNEL_AVX512;
+    }
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return EVX_BATCH_KERNEL_AVX2;
+    }
+#endif
+
+    return EVX_BATCH_KERNEL_SCALAR;
+}
+
+#endif
+
+uint8 entropy_coder_query_batch_kernel()
+{
+#if defined (EVX_BATCH_X86)
+    return evx_batch_query_cpu_kernel();
+#else
+    return EVX_BATCH_KERNEL_SCALAR;
+#endif
+}
+
+evx_status entropy_coder_decode_batch(const entropy_coder_t* prototype, uint32 stream_count, const uint64 *symbol_counts, 
+                                      bitstream_t *sources, bitstream_t *dests, uint8 kernel)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!prototype || (stream_count && (!symbol_counts || !sources || !dests)) || 
+            EVX_ENTROPY_ENGINE_RANGE != prototype->engine || kernel > EVX_BATCH_KERNEL_AVX512) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+
+        for (uint32 i = 0; i < stream_count; ++i)
+        {
+            if (0 == symbol_counts[i])
+            {
+                return evx_post_error(EVX_ERROR_INVALIDARG);
+            }
+        }
+    }
+
+    uint8 supported = entropy_coder_query_batch_kernel();
+
+    if (EVX_BATCH_KERNEL_AUTO == kernel)
+    {
+        kernel = supported;
+    }
+    else if (kernel > supported)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    if (EVX_ENTROPY_MODEL_COUNT == prototype->adaptive)
+    {
+        kernel = EVX_BATCH_KERNEL_SCALAR;
+    }
+
+    evx_batch_group_t group;
+    uint32 width = (EVX_BATCH_KERNEL_AVX512 == kernel) ? 16 : 8;
+
+    for (uint32 first = 0; first < stream_count; first += width)
+    {
+        uint32 lane_count = evx_min2(width, stream_count - first);
+        uint32 steps = 0;
+        evx_status result = EVX_SUCCESS;
+
+        evx_batch_open(&group, prototype, width, &symbol_counts[first], &sources[first], &dests[first], lane_count);
+
+        while (EVX_SUCCESS == result && (steps = evx_batch_begin_block(&group)))
+        {
+            switch (kernel)
+            {
+#if defined (EVX_BATCH_X86)
+                case EVX_BATCH_KERNEL_AVX2: evx_batch_run_avx2(&group, steps); break;
+                case EVX_BATCH_KERNEL_AVX512: evx_batch_run_avx512(&group, steps); break;
+#endif
+                default: evx_batch_run_scalar(&group, steps); break;
+            }
+
+            result = evx_batch_end_block(&group);
+        }
+
+        if (EVX_SUCCESS != evx_batch_close(&group) || EVX_SUCCESS != result)
+        {
+            return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+        }
+    }
+
+    return EVX_SUCCESS;
+}
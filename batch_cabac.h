@@ -0,0 +1,83 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// batch_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_BATCH_CABAC_H__
+#define __EVX_BATCH_CABAC_H__
+
+#include "cabac.h"
+
+#define EVX_BATCH_KERNEL_AUTO               (0)
+#define EVX_BATCH_KERNEL_SCALAR             (1)
+#define EVX_BATCH_KERNEL_AVX2               (2)
+#define EVX_BATCH_KERNEL_AVX512             (3)
+
+#define EVX_BATCH_LANES_MAX                 (16)
+
+/*
+// Batch Decoding
+//
+// entropy_coder_decode_batch decodes many small, independently coded streams 
+// at once. Stream i holds symbol_counts[i] symbols coded with a copy of the 
+// prototype; it is read from sources[i] and written to dests[i]. The result
+// of each stream is identical to calling entropy_coder_decode on it alone.
+//
+// Streams are processed in groups that advance in lockstep, one stream per 
+// vector lane. Every lane resolves its model, compares against its split 
+// point and renormalizes at the same time, and lanes that need input fetch 
+// their next byte from their own stream. The kernels are:
+//
+//  o: EVX_BATCH_KERNEL_SCALAR
+//
+//     Portable C, 8 streams per group. Always available.
+//
+//  o: EVX_BATCH_KERNEL_AVX2
+//
+//     8 streams per group in 256 bit registers.
+//
+//  o: EVX_BATCH_KERNEL_AVX512
+//
+//     16 streams per group in 512 bit registers with mask registers.
+//
+// EVX_BATCH_KERNEL_AUTO picks the widest kernel the processor supports. Batch
+// decoding requires the range engine. The static and shift models run in 
+// the vector kernels; the count model needs a divide per bin and always uses
+// the scalar kernel.
+*/
+
+uint8 entropy_coder_query_batch_kernel();
+
+evx_status entropy_coder_decode_batch(const entropy_coder_t* prototype, uint32 stream_count, const uint64 *symbol_counts, 
+                                      bitstream_t *sources, bitstream_t *dests, uint8 kernel);
+
+#endif // __EVX_BATCH_CABAC_H__
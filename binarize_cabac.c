@@ -0,0 +1,164 @@
+
+#include "binarize_cabac.h"
+
+evx_status entropy_coder_encode_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (value == EVX_MAX_UINT32) 
+        {
+            /* The terminating zero would be dropped. Use truncated unary instead. */
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    return entropy_coder_encode_run(coder, ctx_base, ctx_count, value, EVX_MAX_UINT32);
+}
+
+uint32 entropy_coder_decode_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count)
+{
+    return entropy_coder_decode_run(coder, ctx_base, ctx_count, EVX_MAX_UINT32);
+}
+
+evx_status entropy_coder_encode_truncated_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value, uint32 max_value)
+{
+    return entropy_coder_encode_run(coder, ctx_base, ctx_count, value, max_value);
+}
+
+uint32 entropy_coder_decode_truncated_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 max_value)
+{
+    return entropy_coder_decode_run(coder, ctx_base, ctx_count, max_value);
+}
+
+static uint8 entropy_coder_log2_floor64(uint64 value)
+{
+    uint8 result = 0;
+
+    for (uint8 shift = 32; shift; shift >>= 1)
+    {
+        if (value >> shift)
+        {
+            value >>= shift;
+            result += shift;
+        }
+    }
+
+    return result;
+}
+
+evx_status entropy_coder_encode_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value, uint8 order)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (order > 32) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    /* Prefix length n satisfies 2^k (2^n - 1) <= value < 2^k (2^(n+1) - 1) and
+       the suffix holds value - 2^k (2^n - 1) in k + n bits. For 32 bit values
+       k + n never exceeds 32, so the longest prefix needs no terminating zero. */
+    uint64 offset = (uint64) value + ((uint64) 1 << order);
+    uint8 prefix = entropy_coder_log2_floor64(offset) - order;
+
+    if (EVX_SUCCESS != entropy_coder_encode_run(coder, ctx_base, ctx_count, prefix, 32 - order))
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    return entropy_coder_encode_bypass(coder, (uint32) (offset - ((uint64) 1 << (order + prefix))), order + prefix);
+}
+
+uint32 entropy_coder_decode_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (order > 32) 
+        {
+            evx_post_error(EVX_ERROR_INVALIDARG);
+            return 0;
+        }
+    }
+
+    uint8 prefix = (uint8) entropy_coder_decode_run(coder, ctx_base, ctx_count, 32 - order);
+    uint64 suffix = entropy_coder_decode_bypass(coder, order + prefix);
+
+    return (uint32) (suffix + ((uint64) 1 << (order + prefix)) - ((uint64) 1 << order));
+}
+
+evx_status entropy_coder_encode_signed_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, int32 value, uint8 order)
+{
+    return entropy_coder_encode_exp_golomb(coder, ctx_base, ctx_count, entropy_coder_zigzag_encode(value), order);
+}
+
+int32 entropy_coder_decode_signed_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order)
+{
+    return entropy_coder_zigzag_decode(entropy_coder_decode_exp_golomb(coder, ctx_base, ctx_count, order));
+}
+
+evx_status entropy_coder_encode_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value, uint8 order)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (order > 31) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    uint32 quotient = value >> order;
+
+    if (quotient >= EVX_RICE_PREFIX_LIMIT)
+    {
+        /* Escape: a run of EVX_RICE_PREFIX_LIMIT ones followed by the excess in 
+           Exp-Golomb. The escape run has no terminating zero. */
+        uint64 escape = (uint64) EVX_RICE_PREFIX_LIMIT << order;
+
+        if (EVX_SUCCESS != entropy_coder_encode_run(coder, ctx_base, ctx_count, EVX_RICE_PREFIX_LIMIT, EVX_RICE_PREFIX_LIMIT))
+        {
+            return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+        }
+
+        return entropy_coder_encode_exp_golomb(coder, ctx_base, ctx_count, (uint32) (value - escape), order + 1);
+    }
+
+    if (EVX_SUCCESS != entropy_coder_encode_run(coder, ctx_base, ctx_count, quotient, EVX_RICE_PREFIX_LIMIT))
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    return entropy_coder_encode_bypass(coder, value & ((1u << order) - 1), order);
+}
+
+uint32 entropy_coder_decode_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (order > 31) 
+        {
+            evx_post_error(EVX_ERROR_INVALIDARG);
+            return 0;
+        }
+    }
+
+    uint32 quotient = entropy_coder_decode_run(coder, ctx_base, ctx_count, EVX_RICE_PREFIX_LIMIT);
+
+    if (quotient >= EVX_RICE_PREFIX_LIMIT)
+    {
+        uint32 escape = (uint32) EVX_RICE_PREFIX_LIMIT << order;
+        return escape + entropy_coder_decode_exp_golomb(coder, ctx_base, ctx_count, order + 1);
+    }
+
+    return (quotient << order) | entropy_coder_decode_bypass(coder, order);
+}
+
+evx_status entropy_coder_encode_signed_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, int32 value, uint8 order)
+{
+    return entropy_coder_encode_rice(coder, ctx_base, ctx_count, entropy_coder_zigzag_encode(value), order);
+}
+
+int32 entropy_coder_decode_signed_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order)
+{
+    return entropy_coder_zigzag_decode(entropy_coder_decode_rice(coder, ctx_base, ctx_count, order));
+}
@@ -0,0 +1,108 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// binarize_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_BINARIZE_CABAC_H__
+#define __EVX_BINARIZE_CABAC_H__
+
+#include "cabac.h"
+
+#define EVX_RICE_PREFIX_LIMIT               (16)
+
+/*
+// Binarization
+//
+// Maps integers onto bins for a coder that has an open context session (see 
+// entropy_coder_start_encode and entropy_coder_start_decode). Every scheme 
+// consists of a prefix and an optional suffix:
+//
+//  o The prefix is a run of ones terminated by a zero. Prefix bin i is coded 
+//    with context ctx_base + min(i, ctx_count - 1), so ctx_count contexts
+//    starting at ctx_base must be bound to the coder.
+//
+//  o The suffix is a fixed length field coded as bypass bins.
+//
+// The schemes are:
+//
+//  Unary:            value ones, then a zero. No suffix.
+//
+//  Truncated unary:  unary, but the terminating zero is omitted when value
+//                    equals max_value.
+//
+//  Exp-Golomb (k):   the order grows by one for every prefix one, so large 
+//                    values cost O(log n) bins. Order k values below 2^k 
+//                    cost a single prefix bin. A prefix of 32 - k ones is 
+//                    the longest possible and is not terminated.
+//
+//  Rice (k):         unary quotient (value >> k) and a k bit remainder. A 
+//                    quotient of EVX_RICE_PREFIX_LIMIT or more escapes to 
+//                    Exp-Golomb of order k + 1 using the same contexts, which
+//                    bounds the prefix length for outliers.
+//
+// Signed variants zigzag map the value first (0, -1, 1, -2, ... becomes 
+// 0, 1, 2, 3, ...) so that small magnitudes of either sign stay cheap.
+//
+// Each call codes a whole value with one context run and at most one bypass 
+// field, so there is no per bin call or status overhead. Decoders must be 
+// called with the same parameters the encoder used.
+*/
+
+inline uint32 entropy_coder_zigzag_encode(int32 value)
+{
+    return ((uint32) value << 1) ^ (uint32) (value >> 31);
+}
+
+inline int32 entropy_coder_zigzag_decode(uint32 value)
+{
+    return (int32) (value >> 1) ^ -(int32) (value & 0x1);
+}
+
+evx_status entropy_coder_encode_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value);
+uint32 entropy_coder_decode_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count);
+
+evx_status entropy_coder_encode_truncated_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value, uint32 max_value);
+uint32 entropy_coder_decode_truncated_unary(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 max_value);
+
+evx_status entropy_coder_encode_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value, uint8 order);
+uint32 entropy_coder_decode_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order);
+
+evx_status entropy_coder_encode_signed_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, int32 value, uint8 order);
+int32 entropy_coder_decode_signed_exp_golomb(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order);
+
+evx_status entropy_coder_encode_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 value, uint8 order);
+uint32 entropy_coder_decode_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order);
+
+evx_status entropy_coder_encode_signed_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, int32 value, uint8 order);
+int32 entropy_coder_decode_signed_rice(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint8 order);
+
+#endif // __EVX_BINARIZE_CABAC_H__
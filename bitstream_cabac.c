@@ -8,11 +8,15 @@ void bitstream_create_init(bitstream_t* bs)
   bs->write_index = 0;
   bs->data_store = 0;
   bs->data_capacity = 0;
+  bs->growable = 0;
+  bs->ownership = EVX_BITSTREAM_OWNED;
 }
 
-void bitstream_create_new(bitstream_t* bs, uint32 size)
+void bitstream_create_new(bitstream_t* bs, uint64 size)
 {
   bs->data_store = 0;
+  bs->growable = 0;
+  bs->ownership = EVX_BITSTREAM_OWNED;
 
   if (size != bitstream_resize_capacity(bs, size))
   {
@@ -20,14 +24,17 @@ void bitstream_create_new(bitstream_t* bs, uint32 size)
   }
 }
 
-int bitstream_create_refer(bitstream_t* bs, uint8* source, uint32 size, BOOL flag)
+uint64 bitstream_create_refer(bitstream_t* bs, uint8* source, uint64 size, BOOL flag)
 {
   bs->data_store = 0;
+  bs->growable = 0;
+  bs->ownership = EVX_BITSTREAM_OWNED;
 
   bitstream_clear(bs);
 
-  uint32 byte_size = size;
+  uint64 byte_size = size;
   bs->data_store = source;
+  bs->ownership = EVX_BITSTREAM_BORROWED;
 
   if (!bs->data_store)
   {
@@ -45,9 +52,11 @@ int bitstream_create_refer(bitstream_t* bs, uint8* source, uint32 size, BOOL fla
   return byte_size << 3;
 }
 
-void bitstream_create_assign(bitstream_t* bs, void *bytes, uint32 size)
+void bitstream_create_assign(bitstream_t* bs, void *bytes, uint64 size)
 {
   bs->data_store = 0;
+  bs->growable = 0;
+  bs->ownership = EVX_BITSTREAM_OWNED;
 
     if (0 != bitstream_assign2(bs, bytes, size))
     {
@@ -55,6 +64,23 @@ void bitstream_create_assign(bitstream_t* bs, void *bytes, uint32 size)
     }
 }
 
+void bitstream_create_view(bitstream_t* bs, const void *bytes, uint64 size)
+{
+  bitstream_create_init(bs);
+
+  if (!bytes && size)
+  {
+    evx_post_error(EVX_ERROR_INVALIDARG);
+    return;
+  }
+
+  /* The buffer is only ever read, so casting away const is safe. */
+  bs->data_store = (uint8 *) bytes;
+  bs->data_capacity = size;
+  bs->write_index = size << 3;
+  bs->ownership = EVX_BITSTREAM_READ_ONLY;
+}
+
 //~bitstream() 
 //{
 //    clear();
@@ -65,22 +91,22 @@ const uint8 * bitstream_query_data(const bitstream_t* bs)
     return bs->data_store;
 }
 
-const uint32 bitstream_query_capacity(const bitstream_t* bs)
+const uint64 bitstream_query_capacity(const bitstream_t* bs)
 {
     return bs->data_capacity << 3;
 }
 
-const uint32 bitstream_query_occupancy(const bitstream_t* bs)
+const uint64 bitstream_query_occupancy(const bitstream_t* bs)
 {
     return bs->write_index - bs->read_index;
 }
 
-const uint32 bitstream_query_byte_occupancy(const bitstream_t* bs)
+const uint64 bitstream_query_byte_occupancy(const bitstream_t* bs)
 {
-    return align(bitstream_query_occupancy(bs), 8) >> 3;
+    return align64(bitstream_query_occupancy(bs), 8) >> 3;
 }
 
-uint32 bitstream_resize_capacity(bitstream_t* bs, uint32 size_in_bits)
+uint64 bitstream_resize_capacity(bitstream_t* bs, uint64 size_in_bits)
 {
     if (EVX_PARAM_CHECK) 
     {
@@ -93,8 +119,9 @@ uint32 bitstream_resize_capacity(bitstream_t* bs, uint32 size_in_bits)
 
     bitstream_clear(bs);
 
-    uint32 byte_size = align(size_in_bits, 8) >> 3;
+    uint64 byte_size = align64(size_in_bits, 8) >> 3;
     bs->data_store = malloc(byte_size);
+    bs->ownership = EVX_BITSTREAM_OWNED;
 
     if (!bs->data_store)
     {
@@ -106,7 +133,64 @@ uint32 bitstream_resize_capacity(bitstream_t* bs, uint32 size_in_bits)
     return size_in_bits;
 }
 
-evx_status bitstream_seek(bitstream_t* bs, uint32 bit_offset)
+void bitstream_set_growth(bitstream_t* bs, uint8 growable)
+{
+    bs->growable = growable;
+}
+
+static evx_status bitstream_grow(bitstream_t* bs, uint64 byte_count)
+{
+    if (byte_count <= bs->data_capacity)
+    {
+        return EVX_SUCCESS;
+    }
+
+    /* Every bit of the buffer must remain addressable by a 64 bit index, and
+       the buffer itself must be addressable on this platform. Borrowed buffers
+       are never reallocated. */
+    if (!bs->growable || EVX_BITSTREAM_OWNED != bs->ownership || byte_count > (EVX_MAX_UINT64 >> 3) || byte_count > (size_t) -1)
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    uint64 new_capacity = evx_max2(byte_count, EVX_BITSTREAM_GROWTH_MIN_BYTES);
+
+    if (bs->data_capacity <= (EVX_MAX_UINT64 >> 4))
+    {
+        new_capacity = evx_max2(new_capacity, bs->data_capacity << 1);
+    }
+
+    new_capacity = evx_min2(new_capacity, (uint64) (size_t) -1);
+
+    uint8 *data = realloc(bs->data_store, new_capacity);
+
+    if (!data)
+    {
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    bs->data_store = data;
+    bs->data_capacity = new_capacity;
+
+    return EVX_SUCCESS;
+}
+
+evx_status bitstream_reserve(bitstream_t* bs, uint64 bit_count)
+{
+    if (bs->write_index + bit_count <= bitstream_query_capacity(bs))
+    {
+        return EVX_SUCCESS;
+    }
+
+    if (bit_count > (EVX_MAX_UINT64 - bs->write_index))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    return bitstream_grow(bs, align64(bs->write_index + bit_count, 8) >> 3);
+}
+
+evx_status bitstream_seek(bitstream_t* bs, uint64 bit_offset)
 {
     if (bit_offset >= bs->write_index) 
     {
@@ -117,7 +201,7 @@ evx_status bitstream_seek(bitstream_t* bs, uint32 bit_offset)
     return 0;
 }
 
-evx_status bitstream_assign2(bitstream_t* bs, void *bytes, uint32 size)
+evx_status bitstream_assign2(bitstream_t* bs, void *bytes, uint64 size)
 {
     if (EVX_PARAM_CHECK) 
     {
@@ -131,6 +215,7 @@ evx_status bitstream_assign2(bitstream_t* bs, void *bytes, uint32 size)
 
     /* Copy the data into our own buffer and adjust our indices. */
     bs->data_store = malloc(size);
+    bs->ownership = EVX_BITSTREAM_OWNED;
 
     if (!bs->data_store)
     {
@@ -148,16 +233,25 @@ evx_status bitstream_assign2(bitstream_t* bs, void *bytes, uint32 size)
 
 void bitstream_clear(bitstream_t* bs)
 {
-  bitstream_empty(bs);
+  if (EVX_BITSTREAM_OWNED == bs->ownership)
+  {
+    free(bs->data_store);
+  }
 
-  free(bs->data_store);
+  bs->write_index = 0;
+  bs->read_index = 0;
   bs->data_store = 0;
   bs->data_capacity = 0;
+  bs->ownership = EVX_BITSTREAM_OWNED;
 }
 
 void bitstream_empty(bitstream_t* bs)
 {
-    bs->write_index = 0;
+    if (EVX_BITSTREAM_READ_ONLY != bs->ownership)
+    {
+        bs->write_index = 0;
+    }
+
     bs->read_index = 0;
 }
 
@@ -173,13 +267,13 @@ const uint8 bitstream_is_full(const bitstream_t* bs)
 
 evx_status bitstream_write_byte(bitstream_t* bs, uint8 value)
 {
-    if (bs->write_index + 8 > bitstream_query_capacity(bs))
+    if (EVX_SUCCESS != bitstream_reserve(bs, 8))
     {
         return EVX_ERROR_CAPACITY_LIMIT;
     }
 
     /* Determine the current byte to write. */
-    uint32 dest_byte = bs->write_index >> 3;
+    uint64 dest_byte = bs->write_index >> 3;
     uint8 dest_bit = bs->write_index % 8;
 
     if (0 == dest_bit) 
@@ -203,13 +297,14 @@ evx_status bitstream_write_byte(bitstream_t* bs, uint8 value)
 
 evx_status bitstream_write_bit(bitstream_t* bs, uint8 value)
 {
-    if (bs->write_index + 1 > bitstream_query_capacity(bs))
+    if (bs->write_index + 1 > bitstream_query_capacity(bs) && 
+        EVX_SUCCESS != bitstream_reserve(bs, 1))
     {
         return EVX_ERROR_CAPACITY_LIMIT;
     }
 
     /* Determine the current byte to write. */
-    uint32 dest_byte = bs->write_index >> 3;
+    uint64 dest_byte = bs->write_index >> 3;
     uint8 dest_bit = bs->write_index % 8;
 
     /* Pull the correct byte from our data store, update it, and then store it.
@@ -222,7 +317,7 @@ evx_status bitstream_write_bit(bitstream_t* bs, uint8 value)
     return EVX_SUCCESS;
 }
 
-evx_status bitstream_write_bits(bitstream_t* bs, void *data, uint32 bit_count)
+evx_status bitstream_write_bits(bitstream_t* bs, void *data, uint64 bit_count)
 {
     if (EVX_PARAM_CHECK) 
     {
@@ -232,12 +327,12 @@ evx_status bitstream_write_bits(bitstream_t* bs, void *data, uint32 bit_count)
         }
     }
 
-    if (bs->write_index + bit_count > bitstream_query_capacity(bs))
+    if (EVX_SUCCESS != bitstream_reserve(bs, bit_count))
     {
         return EVX_ERROR_CAPACITY_LIMIT;
     }
 
-    uint32 bits_copied = 0;
+    uint64 bits_copied = 0;
     uint8 *source = (uint8 *)data;
 
     if (0 == (bs->write_index % 8) && (bit_count >= 8))
@@ -267,7 +362,7 @@ evx_status bitstream_write_bits(bitstream_t* bs, void *data, uint32 bit_count)
     return EVX_SUCCESS;
 }
 
-evx_status bitstream_write_bytes(bitstream_t* bs, void *data, uint32 byte_count)
+evx_status bitstream_write_bytes(bitstream_t* bs, void *data, uint64 byte_count)
 {
     return bitstream_write_bits(bs, data, byte_count << 3);
 }
@@ -288,7 +383,7 @@ evx_status bitstream_read_bit(bitstream_t* bs, void *data)
     }
 
     /* Determine the current byte to read from. */
-    uint32 source_byte = bs->read_index >> 3;
+    uint64 source_byte = bs->read_index >> 3;
     uint8 source_bit = bs->read_index % 8;
     uint8 *dest = (uint8 *)data;
 
@@ -317,7 +412,7 @@ evx_status bitstream_read_byte(bitstream_t* bs, void *data)
     }
 
     /* Determine the current byte to read from. */
-    uint32 source_byte = bs->read_index >> 3;
+    uint64 source_byte = bs->read_index >> 3;
     uint8 source_bit = bs->read_index % 8;
     uint8 *dest = (uint8 *)data;
 
@@ -340,7 +435,7 @@ evx_status bitstream_read_byte(bitstream_t* bs, void *data)
     return EVX_SUCCESS;
 }
 
-evx_status bitstream_read_bits(bitstream_t* bs, void *data, uint32 *bit_count)
+evx_status bitstream_read_bits(bitstream_t* bs, void *data, uint64 *bit_count)
 {
     if (EVX_PARAM_CHECK) 
     {
@@ -357,7 +452,7 @@ evx_status bitstream_read_bits(bitstream_t* bs, void *data, uint32 *bit_count)
         (*bit_count) = bs->write_index - bs->read_index;
     }
 
-    uint32 bits_copied = 0;
+    uint64 bits_copied = 0;
     uint8 *dest = (uint8 *)data;
 
     if (0 == (bs->read_index % 8) && ((*bit_count) >= 8 ))
@@ -387,7 +482,7 @@ evx_status bitstream_read_bits(bitstream_t* bs, void *data, uint32 *bit_count)
     return EVX_SUCCESS;
 }
 
-evx_status bitstream_read_bytes(bitstream_t* bs, void *data, uint32 *byte_count)
+evx_status bitstream_read_bytes(bitstream_t* bs, void *data, uint64 *byte_count)
 {
     if (EVX_PARAM_CHECK) 
     {
@@ -397,9 +492,233 @@ evx_status bitstream_read_bytes(bitstream_t* bs, void *data, uint32 *byte_count)
         }
     }
 
-    uint32 bit_count = (*byte_count) << 3;
+    uint64 bit_count = (*byte_count) << 3;
     evx_status result = bitstream_read_bits(bs, data, &bit_count);
     (*byte_count) = bit_count >> 3;
 
     return result;
 }
+
+void bitstream_writer_attach(bitstream_writer_t* writer, bitstream_t* bs)
+{
+    uint8 partial_bits = bs->write_index % 8;
+
+    writer->stream = bs;
+    writer->byte_index = bs->write_index >> 3;
+    writer->cache_bits = partial_bits;
+    writer->cache = 0;
+    writer->sink = 0;
+    writer->sink_param = 0;
+
+    /* Pick up the bits already written to a partially filled byte. */
+    if (partial_bits)
+    {
+        writer->cache = bs->data_store[writer->byte_index] & ((0x1 << partial_bits) - 1);
+    }
+}
+
+void bitstream_writer_set_sink(bitstream_writer_t* writer, bitstream_sink_t sink, void *param)
+{
+    writer->sink = sink;
+    writer->sink_param = param;
+}
+
+static evx_status bitstream_writer_emit(bitstream_writer_t* writer, uint64 byte_count)
+{
+    bitstream_t* bs = writer->stream;
+
+    if (!writer->sink || writer->byte_index + byte_count <= bs->data_capacity)
+    {
+        return EVX_SUCCESS;
+    }
+
+    /* Every stored byte is final, so hand them over and reuse the buffer. */
+    if (writer->byte_index && EVX_SUCCESS != writer->sink(writer->sink_param, bs->data_store, writer->byte_index))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    writer->byte_index = 0;
+
+    return EVX_SUCCESS;
+}
+
+evx_status bitstream_writer_release(bitstream_writer_t* writer)
+{
+    bitstream_t* bs = writer->stream;
+    uint32 byte_count = writer->cache_bits >> 3;
+
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!writer->sink || bs->data_capacity < 8) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_SUCCESS != bitstream_writer_emit(writer, byte_count))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    /* Move the whole bytes out of the cache and keep only the partial byte. */
+    uint8 *data = &(bs->data_store[writer->byte_index]);
+
+    for (uint32 i = 0; i < byte_count; ++i)
+    {
+        data[i] = (uint8) (writer->cache >> (i << 3));
+    }
+
+    writer->byte_index += byte_count;
+    writer->cache_bits -= byte_count << 3;
+    writer->cache = byte_count < 8 ? writer->cache >> (byte_count << 3) : 0;
+
+    if (writer->byte_index && EVX_SUCCESS != writer->sink(writer->sink_param, bs->data_store, writer->byte_index))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    writer->byte_index = 0;
+
+    return EVX_SUCCESS;
+}
+
+evx_status bitstream_writer_drain(bitstream_writer_t* writer)
+{
+    bitstream_t* bs = writer->stream;
+
+    if (EVX_SUCCESS != bitstream_writer_emit(writer, 8) ||
+        EVX_SUCCESS != bitstream_grow(bs, writer->byte_index + 8))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    uint8 *data = &(bs->data_store[writer->byte_index]);
+
+    for (uint8 i = 0; i < 8; ++i)
+    {
+        data[i] = (uint8) (writer->cache >> (i << 3));
+    }
+
+    writer->byte_index += 8;
+    writer->cache = 0;
+    writer->cache_bits = 0;
+
+    return EVX_SUCCESS;
+}
+
+evx_status bitstream_writer_put_run(bitstream_writer_t* writer, uint8 value, uint64 bit_count)
+{
+    uint32 run = value ? EVX_MAX_UINT32 : 0;
+
+    while (bit_count)
+    {
+        uint8 count = (uint8) evx_min2(bit_count, 32);
+
+        if (EVX_SUCCESS != bitstream_writer_put_bits(writer, run, count))
+        {
+            return EVX_ERROR_CAPACITY_LIMIT;
+        }
+
+        bit_count -= count;
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status bitstream_writer_detach(bitstream_writer_t* writer)
+{
+    bitstream_t* bs = writer->stream;
+    uint32 byte_count = writer->cache_bits >> 3;
+    uint8 partial_bits = writer->cache_bits % 8;
+
+    if (EVX_SUCCESS != bitstream_writer_emit(writer, byte_count + (partial_bits ? 1 : 0)))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    bs->write_index = writer->byte_index << 3;
+
+    if (EVX_SUCCESS != bitstream_grow(bs, writer->byte_index + byte_count + (partial_bits ? 1 : 0)))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    uint8 *data = &(bs->data_store[writer->byte_index]);
+
+    for (uint32 i = 0; i < byte_count; ++i)
+    {
+        data[i] = (uint8) (writer->cache >> (i << 3));
+    }
+
+    if (partial_bits)
+    {
+        /* Preserve the unused high bits of the final byte, as bitstream_write_bit does. */
+        uint8 mask = (0x1 << partial_bits) - 1;
+        uint8 bits = (uint8) (writer->cache >> (byte_count << 3));
+        data[byte_count] = (data[byte_count] & ~mask) | (bits & mask);
+    }
+
+    bs->write_index += writer->cache_bits;
+    writer->cache = 0;
+    writer->cache_bits = 0;
+
+    return EVX_SUCCESS;
+}
+
+void bitstream_reader_attach(bitstream_reader_t* reader, bitstream_t* bs)
+{
+    reader->stream = bs;
+    reader->window = 0;
+    reader->window_bits = 0;
+    reader->fill_index = bs->read_index;
+    reader->end_index = bs->write_index;
+}
+
+void bitstream_reader_sync(bitstream_reader_t* reader)
+{
+    /* The window may hold zero padding from beyond the end of the stream. */
+    uint64 read_index = reader->fill_index - reader->window_bits;
+    reader->stream->read_index = evx_min2(read_index, reader->end_index);
+}
+
+void bitstream_reader_detach(bitstream_reader_t* reader)
+{
+    bitstream_reader_sync(reader);
+    reader->window = 0;
+    reader->window_bits = 0;
+}
+
+void bitstream_reader_refill(bitstream_reader_t* reader)
+{
+    const bitstream_t* bs = reader->stream;
+    uint64 source_byte = reader->fill_index >> 3;
+    uint64 chunk = 0;
+
+    if (reader->fill_index + 32 <= reader->end_index && source_byte + 8 <= bs->data_capacity)
+    {
+        /* Fast path: a single unaligned word load covers the next 32 bits. */
+        const uint8 *data = &(bs->data_store[source_byte]);
+        uint64 word = 0;
+
+        for (uint8 i = 0; i < 8; ++i)
+        {
+            word |= (uint64) data[i] << (i << 3);
+        }
+
+        chunk = (word >> (reader->fill_index % 8)) & EVX_MAX_UINT32;
+    }
+    else
+    {
+        /* Slow path near the end of the stream. Missing bits are left as zero. */
+        for (uint64 i = 0; i < 32 && reader->fill_index + i < reader->end_index; ++i)
+        {
+            uint64 index = reader->fill_index + i;
+            chunk |= (uint64) EVX_READ_BIT(bs->data_store[index >> 3], index % 8) << i;
+        }
+    }
+
+    reader->window |= chunk << reader->window_bits;
+    reader->window_bits += 32;
+    reader->fill_index += 32;
+}
@@ -43,31 +43,117 @@
 #define EVX_WRITE_BIT(dest, bit, value)     (dest) = (((dest) & ~(0x1 << (bit))) | \
                                             (((value) & 0x1) << (bit)))
 
+#define EVX_BITSTREAM_GROWTH_MIN_BYTES      (64)
+
+#define EVX_BITSTREAM_OWNED                 (0)
+#define EVX_BITSTREAM_BORROWED              (1)
+#define EVX_BITSTREAM_READ_ONLY             (2)
+
+/*
+// Growth
+//
+// By default a stream has a fixed capacity and writes beyond it fail with 
+// EVX_ERROR_CAPACITY_LIMIT. A stream that owns its buffer may instead be marked
+// growable, in which case a write that does not fit reallocates the buffer to
+// at least twice its current capacity. Use entropy_coder_query_encode_bound to
+// size an output once and avoid reallocating on the hot path entirely.
+*/
+
+/*
+// Ownership
+//
+// A stream normally owns its buffer and frees it in bitstream_clear. Streams
+// may instead wrap caller memory without copying it:
+//
+//  o: bitstream_create_refer    borrows a writable buffer, either empty (an
+//                               output) or full (an input).
+//
+//  o: bitstream_create_view     borrows a read only buffer as a full input. 
+//                               Its write index never moves, so nothing can
+//                               be written through it, and bitstream_empty 
+//                               only rewinds the read index.
+//
+// A borrowed buffer is never freed or reallocated: bitstream_clear simply 
+// forgets it and growth is refused with EVX_ERROR_CAPACITY_LIMIT. The caller
+// must keep the memory alive until the stream is cleared.
+*/
+
 typedef struct 
 {
-  uint32 read_index;
-  uint32 write_index;
-  uint32 data_capacity;
+  uint64 read_index;
+  uint64 write_index;
+  uint64 data_capacity;
   uint8* data_store;
+  uint8 growable;
+  uint8 ownership;
 }bitstream_t, *bitstream_p;
 
+/*
+// Buffered Writer
+//
+// A writer collects bits in a 64 bit cache and stores whole words to the 
+// attached stream, so capacity is checked once per word rather than once per
+// bit. Bits are packed LSB first exactly as bitstream_write_bit packs them. 
+// The stream's write index is not updated until the writer is detached, and
+// the stream must not be touched by other calls while a writer is attached.
+//
+// A writer may also be given a sink. Whenever the stream's buffer cannot hold
+// the next word, the bytes stored so far are handed to the sink and the writer
+// starts again at the front of the buffer, so a small fixed buffer can carry
+// an output of any length. bitstream_writer_release hands over every whole
+// byte written so far without waiting for the buffer to fill.
+*/
+
+typedef evx_status (*bitstream_sink_t)(void *param, const uint8 *data, uint64 byte_count);
+
+typedef struct
+{
+  bitstream_t* stream;
+  uint64 cache;
+  uint32 cache_bits;
+  uint64 byte_index;
+  bitstream_sink_t sink;
+  void *sink_param;
+} bitstream_writer_t;
+
+/*
+// Buffered Reader
+//
+// A reader keeps up to 64 unread bits in a window that is refilled 32 bits at 
+// a time with unaligned word loads. Reads past the stream's write index return
+// zeroes, so a decoder can run off the end of its input without checking. The 
+// stream's read index is not updated until the reader is detached.
+*/
+
+typedef struct
+{
+  bitstream_t* stream;
+  uint64 window;
+  uint32 window_bits;
+  uint64 fill_index;
+  uint64 end_index;
+} bitstream_reader_t;
+
 void bitstream_create_init(bitstream_t* bs);
-void bitstream_create_new(bitstream_t* bs, uint32 size);
-int bitstream_create_refer(bitstream_t* bs, uint8* source, uint32 size, BOOL flag);
-void bitstream_create_assign(bitstream_t* bs, void *bytes, uint32 size);
+void bitstream_create_new(bitstream_t* bs, uint64 size);
+uint64 bitstream_create_refer(bitstream_t* bs, uint8* source, uint64 size, BOOL flag);
+void bitstream_create_assign(bitstream_t* bs, void *bytes, uint64 size);
+void bitstream_create_view(bitstream_t* bs, const void *bytes, uint64 size);
 //virtual ~bitstream();
 
 const uint8 * bitstream_query_data(const bitstream_t* bs);
-const uint32 bitstream_query_capacity(const bitstream_t* bs);
-const uint32 bitstream_query_occupancy(const bitstream_t* bs);
-const uint32 bitstream_query_byte_occupancy(const bitstream_t* bs);
-uint32 bitstream_resize_capacity(bitstream_t* bs, uint32 size_in_bits);
+const uint64 bitstream_query_capacity(const bitstream_t* bs);
+const uint64 bitstream_query_occupancy(const bitstream_t* bs);
+const uint64 bitstream_query_byte_occupancy(const bitstream_t* bs);
+uint64 bitstream_resize_capacity(bitstream_t* bs, uint64 size_in_bits);
+void bitstream_set_growth(bitstream_t* bs, uint8 growable);
+evx_status bitstream_reserve(bitstream_t* bs, uint64 bit_count);
 
 /* seek will only adjust the read index. there is purposely 
     no way to adjust the write index. */
-evx_status bitstream_seek(bitstream_t* bs, uint32 bit_offset);
+evx_status bitstream_seek(bitstream_t* bs, uint64 bit_offset);
 evx_status bitstream_assign1(bitstream_t* bs, const bitstream_t* rvalue);
-evx_status bitstream_assign2(bitstream_t* bs, void *bytes, uint32 size);
+evx_status bitstream_assign2(bitstream_t* bs, void *bytes, uint64 size);
 
 void bitstream_clear(bitstream_t* bs);
 void bitstream_empty(bitstream_t* bs);
@@ -77,13 +163,88 @@ const uint8 bitstream_is_full(const bitstream_t* bs);
 
 evx_status bitstream_write_byte(bitstream_t* bs, uint8 value);
 evx_status bitstream_write_bit(bitstream_t* bs, uint8 value);
-evx_status bitstream_write_bytes(bitstream_t* bs, void *data, uint32 byte_count);
-evx_status bitstream_write_bits(bitstream_t* bs, void *data, uint32 bit_count);
+evx_status bitstream_write_bytes(bitstream_t* bs, void *data, uint64 byte_count);
+evx_status bitstream_write_bits(bitstream_t* bs, void *data, uint64 bit_count);
+
+void bitstream_writer_attach(bitstream_writer_t* writer, bitstream_t* bs);
+evx_status bitstream_writer_detach(bitstream_writer_t* writer);
+evx_status bitstream_writer_drain(bitstream_writer_t* writer);
+void bitstream_writer_set_sink(bitstream_writer_t* writer, bitstream_sink_t sink, void *param);
+evx_status bitstream_writer_release(bitstream_writer_t* writer);
+evx_status bitstream_writer_put_run(bitstream_writer_t* writer, uint8 value, uint64 bit_count);
+
+inline evx_status bitstream_writer_put_bit(bitstream_writer_t* writer, uint8 value)
+{
+    writer->cache |= (uint64) (value & 0x1) << writer->cache_bits;
+
+    if (64 == ++writer->cache_bits)
+    {
+        return bitstream_writer_drain(writer);
+    }
+
+    return EVX_SUCCESS;
+}
+
+/* Writes the low bit_count (<= 32) bits of value, LSB first. */
+inline evx_status bitstream_writer_put_bits(bitstream_writer_t* writer, uint32 value, uint8 bit_count)
+{
+    uint64 bits = value & (((uint64) 0x1 << bit_count) - 1);
+    uint32 free_bits = 64 - writer->cache_bits;
+
+    writer->cache |= bits << writer->cache_bits;
+
+    if (bit_count < free_bits)
+    {
+        writer->cache_bits += bit_count;
+        return EVX_SUCCESS;
+    }
+
+    writer->cache_bits = 64;
+
+    if (EVX_SUCCESS != bitstream_writer_drain(writer))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    writer->cache = bits >> free_bits;
+    writer->cache_bits = bit_count - free_bits;
+
+    return EVX_SUCCESS;
+}
+
+void bitstream_reader_attach(bitstream_reader_t* reader, bitstream_t* bs);
+void bitstream_reader_detach(bitstream_reader_t* reader);
+void bitstream_reader_sync(bitstream_reader_t* reader);
+void bitstream_reader_refill(bitstream_reader_t* reader);
+
+/* Returns the next bit_count (<= 32) bits, LSB first, without consuming them. */
+inline uint32 bitstream_reader_peek(bitstream_reader_t* reader, uint8 bit_count)
+{
+    if (reader->window_bits < bit_count)
+    {
+        bitstream_reader_refill(reader);
+    }
+
+    return (uint32) (reader->window & (((uint64) 0x1 << bit_count) - 1));
+}
+
+inline void bitstream_reader_consume(bitstream_reader_t* reader, uint8 bit_count)
+{
+    reader->window >>= bit_count;
+    reader->window_bits -= bit_count;
+}
+
+inline uint8 bitstream_reader_read_bit(bitstream_reader_t* reader)
+{
+    uint8 bit = (uint8) bitstream_reader_peek(reader, 1);
+    bitstream_reader_consume(reader, 1);
+    return bit;
+}
 
 evx_status bitstream_read_byte(bitstream_t* bs, void *data);
 evx_status bitstream_read_bit(bitstream_t* bs, void *data);
-evx_status bitstream_read_bytes(bitstream_t* bs, void *data, uint32 *byte_count);
-evx_status bitstream_read_bits(bitstream_t* bs, void *data, uint32 *bit_count);
+evx_status bitstream_read_bytes(bitstream_t* bs, void *data, uint64 *byte_count);
+evx_status bitstream_read_bits(bitstream_t* bs, void *data, uint64 *bit_count);
 
  
 #endif // __EVX_BIT_STREAM_H__
@@ -1,5 +1,6 @@
 
 #include "cabac.h"
+#include "rans_cabac.h"
 //#include "math.h"
 
 #define EVX_ENTROPY_PRECISION					(16)
@@ -15,6 +16,37 @@
   #error "EVX_ENTROPY_PRECISION must be <= 32"
 #endif
 
+/* The most bypass bits that are coded with a single interval split. Each 
+   engine keeps at least 2^6 (arithmetic) or 2^8 (range) values per part. */
+#define EVX_ENTROPY_BYPASS_BITS                 (8)
+#define EVX_RANGE_BYPASS_BITS                   (16)
+
+#if defined (EVX_ENTROPY_STATS)
+    #if defined (_M_X64) || defined (__x86_64__)
+        #if defined (EVX_PLATFORM_WINDOWS)
+            #include "intrin.h"
+        #else
+            #include "x86intrin.h"
+        #endif
+        #define EVX_ENTROPY_QUERY_CYCLES()          (__rdtsc())
+    #else
+        #define EVX_ENTROPY_QUERY_CYCLES()          (0)
+    #endif
+
+    #define EVX_ENTROPY_STAT_ADD(coder, field, count)   ((coder)->stats.field += (count))
+    #define EVX_ENTROPY_STAT_E1E2(coder)            do { (coder)->stats.e1e2_shifts++; (coder)->stats.e3_run = 0; } while (0)
+    #define EVX_ENTROPY_STAT_E3(coder)              do { (coder)->stats.e3_shifts++; (coder)->stats.e3_run_max =        \
+                                                         evx_max2((coder)->stats.e3_run_max, ++(coder)->stats.e3_run); } while (0)
+    #define EVX_ENTROPY_STAT_BEGIN()                uint64 stat_cycles = EVX_ENTROPY_QUERY_CYCLES()
+    #define EVX_ENTROPY_STAT_END(coder)             ((coder)->stats.cycles += EVX_ENTROPY_QUERY_CYCLES() - stat_cycles)
+#else
+    #define EVX_ENTROPY_STAT_ADD(coder, field, count)
+    #define EVX_ENTROPY_STAT_E1E2(coder)
+    #define EVX_ENTROPY_STAT_E3(coder)
+    #define EVX_ENTROPY_STAT_BEGIN()
+    #define EVX_ENTROPY_STAT_END(coder)
+#endif
+
 
 /* 
 // ABAC Ranging
@@ -26,34 +58,109 @@
 // When encoding a one, low should be set to mid + 1, high remains the same. 
 */
 
+/*
+// Range Engine
+//
+// + Our range for 0 is [low, low + mid)
+// + Our range for 1 is [low + mid, low + range)
+//
+// The encoder low is 64 bits wide so that a carry out of the top byte can be
+// detected and folded into the cached byte run before it is written. The 
+// decoder keeps a 32 bit low that wraps in step with value, so value - low is
+// always the offset of the codeword within the current range.
+*/
+
+static void entropy_coder_reset_range(entropy_coder_t* coder)
+{
+  coder->wide_low = 0;
+  coder->range = EVX_MAX_UINT32;
+  coder->cache_size = 1;
+  coder->cache = 0;
+}
+
+static void entropy_coder_reset_bindings(entropy_coder_t* coder)
+{
+  coder->contexts = 0;
+  coder->context_count = 0;
+  coder->writer.stream = 0;
+  coder->reader.stream = 0;
+}
+
 void entropy_coder_init1(entropy_coder_t* coder)
 {
   coder->history[0] = 1;
   coder->history[1] = 1;
+  coder->initial_history[0] = 1;
+  coder->initial_history[1] = 1;
+  coder->initial_model = EVX_ENTROPY_HALF_RANGE;
 
   coder->e3_count = 0;
-  coder->adaptive = 1;
+  coder->adaptive = EVX_ENTROPY_MODEL_COUNT;
+  coder->engine = EVX_ENTROPY_ENGINE_ARITHMETIC;
+  coder->rate = 0;
   coder->model = EVX_ENTROPY_HALF_RANGE;
   coder->value = 0;
 
   coder->low = 0;
   coder->high = EVX_ENTROPY_PRECISION_MAX;
   coder->mid = EVX_ENTROPY_HALF_RANGE;
+
+  entropy_coder_reset_range(coder);
+  entropy_coder_reset_bindings(coder);
+  entropy_coder_reset_stats(coder);
 }
 
 void entropy_coder_init2(entropy_coder_t* coder, uint32 input_model)
 {
   coder->history[0] = 0;
   coder->history[1] = 0;
+  coder->initial_history[0] = 0;
+  coder->initial_history[1] = 0;
+  coder->initial_model = input_model;
 
   coder->model = input_model;
   coder->e3_count = 0;
-  coder->adaptive = 0;
+  coder->adaptive = EVX_ENTROPY_MODEL_STATIC;
+  coder->engine = EVX_ENTROPY_ENGINE_ARITHMETIC;
+  coder->rate = 0;
   coder->value = 0;
 
   coder->low	= 0;
   coder->high = EVX_ENTROPY_PRECISION_MAX;
   coder->mid = coder->model;
+
+  entropy_coder_reset_range(coder);
+  entropy_coder_reset_bindings(coder);
+  entropy_coder_reset_stats(coder);
+}
+
+void entropy_coder_init3(entropy_coder_t* coder, uint8 rate)
+{
+  if (rate < EVX_ENTROPY_RATE_MIN || rate > EVX_ENTROPY_RATE_MAX)
+  {
+    rate = EVX_ENTROPY_RATE_DEFAULT;
+  }
+
+  coder->history[0] = 0;
+  coder->history[1] = 0;
+  coder->initial_history[0] = 0;
+  coder->initial_history[1] = 0;
+  coder->initial_model = EVX_ENTROPY_PROBABILITY_HALF;
+
+  coder->model = EVX_ENTROPY_PROBABILITY_HALF;
+  coder->e3_count = 0;
+  coder->adaptive = EVX_ENTROPY_MODEL_SHIFT;
+  coder->engine = EVX_ENTROPY_ENGINE_ARITHMETIC;
+  coder->rate = rate;
+  coder->value = 0;
+
+  coder->low = 0;
+  coder->high = EVX_ENTROPY_PRECISION_MAX;
+  coder->mid = EVX_ENTROPY_HALF_RANGE;
+
+  entropy_coder_reset_range(coder);
+  entropy_coder_reset_bindings(coder);
+  entropy_coder_reset_stats(coder);
 }
 
 void entropy_coder_clear(entropy_coder_t* coder)
@@ -61,14 +168,22 @@ void entropy_coder_clear(entropy_coder_t* coder)
   coder->low	= 0;
   coder->value = 0;
   coder->e3_count = 0;
+
+  entropy_coder_reset_range(coder);
   
-    if (coder->adaptive)
+    if (EVX_ENTROPY_MODEL_COUNT == coder->adaptive)
     {
-      coder->history[0] = 1;
-      coder->history[1] = 1;
+      coder->history[0] = coder->initial_history[0];
+      coder->history[1] = coder->initial_history[1];
       coder->high = EVX_ENTROPY_PRECISION_MAX;
       coder->mid	= EVX_ENTROPY_HALF_RANGE;
     } 
+    else if (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive)
+    {
+      coder->model = coder->initial_model;
+      coder->high = EVX_ENTROPY_PRECISION_MAX;
+      coder->mid = EVX_ENTROPY_HALF_RANGE;
+    }
     else 
     {
       coder->high = EVX_ENTROPY_PRECISION_MAX;
@@ -76,12 +191,117 @@ void entropy_coder_clear(entropy_coder_t* coder)
     }
 }
 
+evx_status entropy_coder_select_engine(entropy_coder_t* coder, uint8 engine)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || engine > EVX_ENTROPY_ENGINE_RANS) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    coder->engine = engine;
+    entropy_coder_clear(coder);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_query_stats(const entropy_coder_t* coder, entropy_coder_stats_t *stats)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !stats) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+#if defined (EVX_ENTROPY_STATS)
+    *stats = coder->stats;
+    stats->zeros = stats->bins - stats->ones;
+
+    return EVX_SUCCESS;
+#else
+    memset(stats, 0, sizeof(entropy_coder_stats_t));
+
+    return EVX_ERROR_NOTIMPL;
+#endif
+}
+
+void entropy_coder_reset_stats(entropy_coder_t* coder)
+{
+#if defined (EVX_ENTROPY_STATS)
+    memset(&coder->stats, 0, sizeof(entropy_coder_stats_t));
+#else
+    (void) coder;
+#endif
+}
+
+uint32 entropy_coder_query_probability(const entropy_coder_t* coder)
+{
+    uint32 probability = 0;
+
+    if (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive)
+    {
+        return coder->model;
+    }
+    else if (EVX_ENTROPY_MODEL_COUNT == coder->adaptive)
+    {
+        probability = (uint32) (((uint64) coder->history[0] << EVX_ENTROPY_PROBABILITY_BITS) / 
+                                (coder->history[0] + coder->history[1]));
+    }
+    else
+    {
+        probability = coder->model;
+    }
+
+    /* Neither symbol may be assigned an empty range. */
+    return evx_max2(1, evx_min2(probability, EVX_ENTROPY_PROBABILITY_ONE - 1));
+}
+
+static void entropy_coder_split(entropy_coder_t* coder, uint32 probability)
+{
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        coder->mid = (coder->range >> EVX_ENTROPY_PROBABILITY_BITS) * probability;
+        return;
+    }
+
+    /* range and probability are both below 2^16, so this fits in 32 bits. */
+    coder->mid = coder->low + (((coder->high - coder->low) * probability) >> EVX_ENTROPY_PROBABILITY_BITS);
+}
+
+static uint32 entropy_coder_adapt(uint32 probability, uint8 value, uint8 rate)
+{
+    /* The update self-clamps: probability can never reach zero or ONE, so 
+       neither symbol is ever assigned an empty range. */
+    if (value) 
+    {
+        return probability - (probability >> rate);
+    } 
+
+    return probability + ((EVX_ENTROPY_PROBABILITY_ONE - probability) >> rate);
+}
+
 void entropy_coder_resolve_model(entropy_coder_t* coder)
 {
+    if (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive)
+    {
+        entropy_coder_split(coder, coder->model);
+        return;
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        entropy_coder_split(coder, entropy_coder_query_probability(coder));
+        return;
+    }
+
     uint64 mid_range = 0; 
     uint64 range = coder->high - coder->low;
     
-    if (coder->adaptive)
+    if (EVX_ENTROPY_MODEL_COUNT == coder->adaptive)
     {
         mid_range = range * coder->history[0] / (coder->history[0] + coder->history[1]);
     } 
@@ -93,21 +313,41 @@ void entropy_coder_resolve_model(entropy_coder_t* coder)
     coder->mid = coder->low + mid_range;
 }
 
-evx_status entropy_coder_encode_symbol(entropy_coder_t* coder, uint8 value)
+void entropy_coder_update_model(entropy_coder_t* coder, uint8 value)
 {
-    /* We only encode the first 2 GB instances of each symbol. */
-    if (coder->history[value] >= (2 * EVX_GB))
+    if (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive)
     {
-        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+        coder->model = entropy_coder_adapt(coder->model, value, coder->rate);
     }
+    else if (EVX_ENTROPY_MODEL_COUNT == coder->adaptive)
+    {
+        if (++coder->history[value] >= EVX_ENTROPY_HISTORY_LIMIT)
+        {
+            /* Rescale rather than overflow. Rounding up keeps both counts non-zero. */
+            coder->history[0] = (coder->history[0] + 1) >> 1;
+            coder->history[1] = (coder->history[1] + 1) >> 1;
+        }
+    }
+}
 
-    /* Adapt our model with knowledge of our recently processed value. */
-    entropy_coder_resolve_model(coder);
-
-    /* Encode our bit. */
-    value = value & 0x1;
+static void entropy_coder_code_bit(entropy_coder_t* coder, uint8 value)
+{
+    EVX_ENTROPY_STAT_ADD(coder, bins, 1);
+    EVX_ENTROPY_STAT_ADD(coder, ones, value);
 
-    if (value) 
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        if (value) 
+        {
+            coder->wide_low += coder->mid;
+            coder->range -= coder->mid;
+        } 
+        else 
+        {
+            coder->range = coder->mid;
+        }
+    }
+    else if (value) 
     {
       coder->low = coder->mid + 1;
     } 
@@ -115,12 +355,61 @@ evx_status entropy_coder_encode_symbol(entropy_coder_t* coder, uint8 value)
     {
       coder->high = coder->mid;
     }
+}
+
+static uint8 entropy_coder_resolve_bit(entropy_coder_t* coder, uint32 value)
+{
+    EVX_ENTROPY_STAT_ADD(coder, bins, 1);
+
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        if (value - coder->low < coder->mid)
+        {
+            coder->range = coder->mid;
+            return 0;
+        }
+
+        coder->low += coder->mid;
+        coder->range -= coder->mid;
+        EVX_ENTROPY_STAT_ADD(coder, ones, 1);
+        return 1;
+    }
+
+    if (value <= coder->mid)
+    {
+      coder->high = coder->mid;
+      return 0;
+    } 
+
+    coder->low = coder->mid + 1;
+    EVX_ENTROPY_STAT_ADD(coder, ones, 1);
+    return 1;
+}
+
+evx_status entropy_coder_encode_symbol(entropy_coder_t* coder, uint8 value)
+{
+    /* Adapt our model with knowledge of our recently processed value. */
+    entropy_coder_resolve_model(coder);
 
-    coder->history[value]++;
+    /* Encode our bit. */
+    value = value & 0x1;
+    entropy_coder_code_bit(coder, value);
+    entropy_coder_update_model(coder, value);
 
     return EVX_SUCCESS;
 }
 
+static uint8 entropy_coder_decode_bit(entropy_coder_t* coder, uint32 value)
+{
+    /* Adapt our model with knowledge of our recently processed value. */
+    entropy_coder_resolve_model(coder);
+
+    uint8 bit = entropy_coder_resolve_bit(coder, value);
+    entropy_coder_update_model(coder, bit);
+
+    return bit;
+}
+
 evx_status entropy_coder_decode_symbol(entropy_coder_t* coder, uint32 value, bitstream_t *dest)
 {
     if (EVX_PARAM_CHECK) 
@@ -131,23 +420,20 @@ evx_status entropy_coder_decode_symbol(entropy_coder_t* coder, uint32 value, bit
         }
     }
 
-    /* Adapt our model with knowledge of our recently processed value. */
-    entropy_coder_resolve_model(coder);
+    return bitstream_write_bit(dest, entropy_coder_decode_bit(coder, value));
+}
 
-    /* Decode our bit. */
-    if (value >= coder->low && value <= coder->mid)
-    {
-      coder->high = coder->mid;
-      coder->history[0]++;
-      bitstream_write_bit(dest, 0);
-    } 
-    else if (value > coder->mid && value <= coder->high)
+static evx_status entropy_coder_write_inverse_bits(entropy_coder_t* coder, uint8 value, bitstream_writer_t *writer)
+{
+    if (EVX_SUCCESS != bitstream_writer_put_run(writer, !value, coder->e3_count))
     {
-      coder->low = coder->mid + 1;
-      coder->history[1]++;
-      bitstream_write_bit(dest, 1);
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
     }
 
+    EVX_ENTROPY_STAT_ADD(coder, follow_bits, coder->e3_count);
+    EVX_ENTROPY_STAT_ADD(coder, stream_bits, coder->e3_count);
+    coder->e3_count = 0;
+
     return EVX_SUCCESS;
 }
 
@@ -161,29 +447,66 @@ evx_status entropy_coder_flush_inverse_bits(entropy_coder_t* coder, uint8 value,
         }
     }
 
-    value = !value;
+    bitstream_writer_t writer;
+    bitstream_writer_attach(&writer, dest);
+
+    evx_status result = entropy_coder_write_inverse_bits(coder, value, &writer);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    return result;
+}
 
-    for (uint32 i = 0; i < coder->e3_count; ++i)
+static evx_status entropy_coder_shift_low(entropy_coder_t* coder, bitstream_writer_t *writer)
+{
+    if ((uint32) coder->wide_low < 0xFF000000 || (coder->wide_low >> 32))
     {
-        if (EVX_SUCCESS != bitstream_write_bit(dest, value)) 
+        /* The top byte of low is final (or has just received its carry), so we
+           can release the cached byte and any run of 0xFF bytes behind it. */
+        uint8 carry = (uint8) (coder->wide_low >> 32);
+        uint8 temp = coder->cache;
+
+        EVX_ENTROPY_STAT_ADD(coder, carries, carry);
+        EVX_ENTROPY_STAT_ADD(coder, stream_bits, coder->cache_size << 3);
+
+        do
         {
-            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
-        }
+            if (EVX_SUCCESS != bitstream_writer_put_bits(writer, (uint8) (temp + carry), 8))
+            {
+                return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+            }
+
+            temp = 0xFF;
+        } while (--coder->cache_size);
+
+        coder->cache = (uint8) (coder->wide_low >> 24);
     }
 
-    coder->e3_count = 0;
+    coder->cache_size++;
+    coder->wide_low = (coder->wide_low & 0x00FFFFFF) << 8;
 
     return EVX_SUCCESS;
 }
 
-evx_status entropy_coder_resolve_encode_scaling(entropy_coder_t* coder, bitstream_t *dest)
+static evx_status entropy_coder_scale_encoder(entropy_coder_t* coder, bitstream_writer_t *writer)
 {
-    if (EVX_PARAM_CHECK) 
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
     {
-        if (!dest) 
+        while (coder->range < EVX_RANGE_TOP)
         {
-            return evx_post_error(EVX_ERROR_INVALIDARG);
+            coder->range <<= 8;
+            EVX_ENTROPY_STAT_ADD(coder, byte_shifts, 1);
+
+            if (EVX_SUCCESS != entropy_coder_shift_low(coder, writer))
+            {
+                return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+            }
         }
+
+        return EVX_SUCCESS;
     }
 
     while (1) 
@@ -195,12 +518,15 @@ evx_status entropy_coder_resolve_encode_scaling(entropy_coder_t* coder, bitstrea
             coder->low -= EVX_ENTROPY_HALF_RANGE * msb + msb;
             coder->high -= EVX_ENTROPY_HALF_RANGE * msb + msb;
 
-            if (EVX_SUCCESS != bitstream_write_bit(dest, msb))
+            if (EVX_SUCCESS != bitstream_writer_put_bit(writer, msb))
             {
                 return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
             }
 
-            if (EVX_SUCCESS != entropy_coder_flush_inverse_bits(coder, msb, dest))
+            EVX_ENTROPY_STAT_E1E2(coder);
+            EVX_ENTROPY_STAT_ADD(coder, stream_bits, 1);
+
+            if (coder->e3_count && EVX_SUCCESS != entropy_coder_write_inverse_bits(coder, msb, writer))
             {
                 return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
             }
@@ -211,6 +537,7 @@ evx_status entropy_coder_resolve_encode_scaling(entropy_coder_t* coder, bitstrea
           coder->high -= EVX_ENTROPY_QTR_RANGE + 1;
           coder->low	-= EVX_ENTROPY_QTR_RANGE + 1;
           coder->e3_count += 1;
+          EVX_ENTROPY_STAT_E3(coder);
         } 
         else 
         {
@@ -224,17 +551,51 @@ evx_status entropy_coder_resolve_encode_scaling(entropy_coder_t* coder, bitstrea
     return EVX_SUCCESS;
 }
 
-evx_status entropy_coder_resolve_decode_scaling(entropy_coder_t* coder, uint32 *value, bitstream_t *source, bitstream_t *dest)
+evx_status entropy_coder_resolve_encode_scaling(entropy_coder_t* coder, bitstream_t *dest)
 {
     if (EVX_PARAM_CHECK) 
     {
-        if (!value || !source || !dest) 
+        if (!dest) 
         {
             return evx_post_error(EVX_ERROR_INVALIDARG);
         }
     }
 
-    uint8 bit = 0;
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        /* rANS codes whole blocks in reverse and has no incremental form. */
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    bitstream_writer_t writer;
+    bitstream_writer_attach(&writer, dest);
+
+    evx_status result = entropy_coder_scale_encoder(coder, &writer);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    return result;
+}
+
+static void entropy_coder_scale_decoder(entropy_coder_t* coder, uint32 *value, bitstream_reader_t *reader)
+{
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        while (coder->range < EVX_RANGE_TOP)
+        {
+            coder->range <<= 8;
+            coder->low <<= 8;
+            *value = (*value << 8) | bitstream_reader_peek(reader, 8);
+            bitstream_reader_consume(reader, 8);
+            EVX_ENTROPY_STAT_ADD(coder, byte_shifts, 1);
+            EVX_ENTROPY_STAT_ADD(coder, stream_bits, 8);
+        }
+
+        return;
+    }
 
     while (1) 
     {
@@ -242,12 +603,14 @@ evx_status entropy_coder_resolve_decode_scaling(entropy_coder_t* coder, uint32 *
         {
             /* If our high value is less than half we do nothing (but
                prevent the loop from exiting). */
+            EVX_ENTROPY_STAT_E1E2(coder);
         } 
         else if (coder->low > EVX_ENTROPY_HALF_RANGE)
         {
           coder->high -= (EVX_ENTROPY_HALF_RANGE + 1);
           coder->low	-= (EVX_ENTROPY_HALF_RANGE + 1);
             *value -= (EVX_ENTROPY_HALF_RANGE + 1);
+            EVX_ENTROPY_STAT_E1E2(coder);
         }	
         else if (coder->high <= EVX_ENTROPY_3QTR_RANGE && coder->low > EVX_ENTROPY_QTR_RANGE)
         {
@@ -255,173 +618,1275 @@ evx_status entropy_coder_resolve_decode_scaling(entropy_coder_t* coder, uint32 *
           coder->high -= EVX_ENTROPY_QTR_RANGE + 1;
           coder->low	-= EVX_ENTROPY_QTR_RANGE + 1;
             *value -= EVX_ENTROPY_QTR_RANGE + 1;
+            EVX_ENTROPY_STAT_E3(coder);
         } 
         else
         {
             break;
         }   
 
-        if (!bitstream_is_empty(source)) 
-        {
-            if (EVX_SUCCESS != bitstream_read_bit(source, &bit)) 
-            {
-                return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
-            }
-        }
-
         coder->high = ((coder->high << 0x1) & EVX_ENTROPY_PRECISION_MAX) | 0x1;
         coder->low = ((coder->low  << 0x1) & EVX_ENTROPY_PRECISION_MAX) | 0x0;
-        *value = ((*value << 0x1) & EVX_ENTROPY_PRECISION_MAX) | bit;
+        *value = ((*value << 0x1) & EVX_ENTROPY_PRECISION_MAX) | bitstream_reader_read_bit(reader);
+        EVX_ENTROPY_STAT_ADD(coder, stream_bits, 1);
     }
-
-    return EVX_SUCCESS;
 }
 
-evx_status entropy_coder_flush_encoder(entropy_coder_t* coder, bitstream_t *dest)
+evx_status entropy_coder_resolve_decode_scaling(entropy_coder_t* coder, uint32 *value, bitstream_t *source, bitstream_t *dest)
 {
     if (EVX_PARAM_CHECK) 
     {
-        if (!dest) 
+        if (!value || !source || !dest) 
         {
             return evx_post_error(EVX_ERROR_INVALIDARG);
         }
     }
 
-    coder->e3_count++;
-
-    if (coder->low < EVX_ENTROPY_QTR_RANGE)
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
     {
-        if (EVX_SUCCESS != bitstream_write_bit(dest, 0) || 
-            EVX_SUCCESS != entropy_coder_flush_inverse_bits(coder, 0, dest)) 
-        {
-            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
-        }
-    } 
-    else 
-    {
-        if (EVX_SUCCESS != bitstream_write_bit(dest, 1) ||
-            EVX_SUCCESS != entropy_coder_flush_inverse_bits(coder, 1, dest)) 
-        {
-            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
-        }
+        return evx_post_error(EVX_ERROR_NOTIMPL);
     }
 
-    entropy_coder_clear(coder);
+    bitstream_reader_t reader;
+    bitstream_reader_attach(&reader, source);
+    entropy_coder_scale_decoder(coder, value, &reader);
+    bitstream_reader_detach(&reader);
 
     return EVX_SUCCESS;
 }
 
-evx_status entropy_coder_encode(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest)
+static evx_status entropy_coder_flush_writer(entropy_coder_t* coder, bitstream_writer_t *writer)
 {
-    if (EVX_PARAM_CHECK) 
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
     {
-        if (!source || !dest) 
+        /* Push every byte of low (and the cached run) into the stream. */
+        for (uint32 i = 0; i < EVX_RANGE_FLUSH_BYTES; ++i)
         {
-            return evx_post_error(EVX_ERROR_INVALIDARG);
+            if (EVX_SUCCESS != entropy_coder_shift_low(coder, writer))
+            {
+                return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+            }
         }
+
+        entropy_coder_clear(coder);
+
+        return EVX_SUCCESS;
     }
 
-    uint8 value = 0;
+    coder->e3_count++;
+
+    uint8 msb = (coder->low < EVX_ENTROPY_QTR_RANGE) ? 0 : 1;
 
-    while (!bitstream_is_empty(source)) 
+    if (EVX_SUCCESS != bitstream_writer_put_bit(writer, msb) || 
+        EVX_SUCCESS != entropy_coder_write_inverse_bits(coder, msb, writer)) 
     {
-        if (EVX_SUCCESS != bitstream_read_bit(source, &value) ||
-            EVX_SUCCESS != entropy_coder_encode_symbol(coder, value) ||
-            EVX_SUCCESS != entropy_coder_resolve_encode_scaling(coder, dest)) 
-        {
-            return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
-        }
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
     }
 
-    //if (auto_finish) 
-    //{
-        /* We close out the tab here in order to remain consistent with the decode
-           behavior. If stream support is required, this will require an update. */
-        if (EVX_SUCCESS != entropy_coder_flush_encoder(coder, dest)) 
-        {
-            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
-        }
+    EVX_ENTROPY_STAT_ADD(coder, stream_bits, 1);
 
-        entropy_coder_clear(coder);
-    //}
+    entropy_coder_clear(coder);
 
     return EVX_SUCCESS;
 }
 
-evx_status entropy_coder_decode(entropy_coder_t* coder, uint32 symbol_count, bitstream_t *source, bitstream_t *dest)
+evx_status entropy_coder_flush_encoder(entropy_coder_t* coder, bitstream_t *dest)
 {
     if (EVX_PARAM_CHECK) 
     {
-        if (0 == symbol_count || !source || !dest ) 
+        if (!dest) 
         {
             return evx_post_error(EVX_ERROR_INVALIDARG);
         }
     }
 
-    //if (auto_start) 
-    //{
-        uint8 bit = 0;
-        coder->value = 0;
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    bitstream_writer_t writer;
+    bitstream_writer_attach(&writer, dest);
+
+    evx_status result = entropy_coder_flush_writer(coder, &writer);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    return result;
+}
+
+static uint32 entropy_coder_floor_log2(uint64 value)
+{
+    uint32 result = 0;
+
+    while (value >>= 1)
+    {
+        result++;
+    }
+
+    return result;
+}
+
+uint64 entropy_coder_query_encode_bound(const entropy_coder_t* coder, uint64 bit_count)
+{
+    uint64 bits = 0;
+    uint64 symbol_cost = 0;
+
+    if (EVX_ENTROPY_MODEL_COUNT == coder->adaptive)
+    {
+        /* An adaptive counting model never spends more than n + log2(n + 1) bits
+           on any sequence of n symbols. */
+        bits = bit_count + entropy_coder_floor_log2(bit_count + 1) + 1;
+
+        if (bit_count >= (EVX_ENTROPY_HISTORY_LIMIT >> 1))
+        {
+            /* A rescale of the history costs at most one extra bit for each
+               symbol coded since the previous rescale. */
+            bits += bit_count;
+        }
+    }
+    else
+    {
+        /* Otherwise we bound every symbol by the cost of the least likely symbol
+           that the model can represent. */
+        uint32 least = 1;
+
+        if (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive)
+        {
+            least = ((uint32) 0x1 << coder->rate) - 1;
+        }
+        else
+        {
+            least = evx_min2(coder->model, EVX_ENTROPY_PRECISION_MAX - evx_min2(coder->model, EVX_ENTROPY_PRECISION_MAX));
+        }
+
+        symbol_cost = EVX_ENTROPY_PROBABILITY_BITS - entropy_coder_floor_log2(evx_max2(least, 1));
+        bits = symbol_cost * bit_count;
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        /* Rounding in a state 2^15 times wider than the probabilities costs far
+           less than 1/4096 bit per symbol. Each block adds its final state and
+           up to one partially used word. */
+        uint64 blocks = (bit_count + EVX_RANS_BLOCK_BINS - 1) / EVX_RANS_BLOCK_BINS;
+        bits += (bit_count >> 12) + 1;
+        bits += blocks * (EVX_RANS_STATE_BITS + EVX_RANS_WORD_BITS);
+    }
+    else if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        /* Truncating the range to 16 bits of precision costs < 1/64 bit per symbol. */
+        bits += (bit_count >> 6) + 1;
+        bits += (EVX_RANGE_FLUSH_BYTES + 1) << 3;
+    }
+    else
+    {
+        /* Integer ranging costs < 1/4096 bit per symbol, plus the final flush. */
+        bits += (bit_count >> 12) + 1;
+        bits += 2 * EVX_ENTROPY_PRECISION;
+    }
+
+    return (bits + 7) >> 3;
+}
+
+static void entropy_coder_count_block(entropy_coder_t* coder, const bitstream_t *bins, uint64 bin_offset, uint64 bin_count, uint64 stream_bits)
+{
+#if defined (EVX_ENTROPY_STATS)
+    /* rANS codes whole blocks internally, so its bins are counted afterwards. */
+    coder->stats.bins += bin_count;
+    coder->stats.stream_bits += stream_bits;
+
+    for (uint64 i = bin_offset; i < bin_offset + bin_count; ++i)
+    {
+        coder->stats.ones += (bins->data_store[i >> 3] >> (i & 7)) & 0x1;
+    }
+#else
+    (void) coder;
+    (void) bins;
+    (void) bin_offset;
+    (void) bin_count;
+    (void) stream_bits;
+#endif
+}
+
+static evx_status entropy_coder_encode_source(entropy_coder_t* coder, uint64 bit_count, bitstream_reader_t *reader, bitstream_writer_t *writer)
+{
+    EVX_ENTROPY_STAT_BEGIN();
+
+    while (bit_count) 
+    {
+        /* Pull up to 32 source bits at a time and code them LSB first. */
+        uint8 count = (uint8) evx_min2(bit_count, 32);
+        uint32 bits = bitstream_reader_peek(reader, count);
+        bitstream_reader_consume(reader, count);
+        bit_count -= count;
+
+        for (uint8 i = 0; i < count; ++i, bits >>= 1)
+        {
+            if (EVX_SUCCESS != entropy_coder_encode_symbol(coder, bits & 0x1) ||
+                EVX_SUCCESS != entropy_coder_scale_encoder(coder, writer)) 
+            {
+                EVX_ENTROPY_STAT_END(coder);
+                return EVX_ERROR_INVALID_RESOURCE;
+            }
+        }
+    }
+
+    EVX_ENTROPY_STAT_END(coder);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_encode(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        uint64 bin_offset = source->read_index;
+        uint64 stream_offset = dest->write_index;
+
+        EVX_ENTROPY_STAT_BEGIN();
+        evx_status result = entropy_coder_encode_rans(coder, source, dest);
+        EVX_ENTROPY_STAT_END(coder);
+
+        entropy_coder_count_block(coder, source, bin_offset, source->read_index - bin_offset, dest->write_index - stream_offset);
+
+        return result;
+    }
+
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+
+    if (EVX_SUCCESS != entropy_coder_encode_source(coder, bitstream_query_occupancy(source), &reader, &writer))
+    {
+        bitstream_reader_detach(&reader);
+        bitstream_writer_detach(&writer);
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    bitstream_reader_detach(&reader);
+
+    //if (auto_finish) 
+    //{
+        /* We close out the tab here in order to remain consistent with the decode
+           behavior. Open ended streams are coded with stream_cabac.h instead. */
+        if (EVX_SUCCESS != entropy_coder_flush_writer(coder, &writer) ||
+            EVX_SUCCESS != bitstream_writer_detach(&writer)) 
+        {
+            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+        }
+
+        entropy_coder_clear(coder);
+    //}
+
+    return EVX_SUCCESS;
+}
+
+static void entropy_coder_prime_decoder(entropy_coder_t* coder, bitstream_reader_t *reader)
+{
+    coder->value = 0;
+
+    entropy_coder_clear(coder);
+
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        /* The first byte is always zero and falls off the top of value. */
+        for (uint32 i = 0; i < EVX_RANGE_FLUSH_BYTES; ++i) 
+        {
+            coder->value = (coder->value << 8) | bitstream_reader_peek(reader, 8);
+            bitstream_reader_consume(reader, 8);
+        }
+
+        EVX_ENTROPY_STAT_ADD(coder, stream_bits, EVX_RANGE_FLUSH_BYTES << 3);
+        return;
+    }
+
+    /* We read in our initial bits with padded tailing zeroes. */
+    for (uint32 i = 0; i < EVX_ENTROPY_PRECISION; ++i) 
+    {
+        coder->value <<= 0x1;
+        coder->value |= bitstream_reader_read_bit(reader);
+    }
+
+    EVX_ENTROPY_STAT_ADD(coder, stream_bits, EVX_ENTROPY_PRECISION);
+}
+
+static evx_status entropy_coder_decode_source(entropy_coder_t* coder, uint64 symbol_count, bitstream_reader_t *reader, bitstream_writer_t *writer)
+{
+    EVX_ENTROPY_STAT_BEGIN();
+
+    for (uint64 i = 0; i < symbol_count; ++i) 
+    {
+        if (EVX_SUCCESS != bitstream_writer_put_bit(writer, entropy_coder_decode_bit(coder, coder->value)))
+        {
+            EVX_ENTROPY_STAT_END(coder);
+            return EVX_ERROR_CAPACITY_LIMIT;
+        }
+
+        entropy_coder_scale_decoder(coder, &(coder->value), reader);
+    }
+
+    EVX_ENTROPY_STAT_END(coder);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_decode(entropy_coder_t* coder, uint64 symbol_count, bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (0 == symbol_count || !source || !dest ) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        uint64 bin_offset = dest->write_index;
+        uint64 stream_offset = source->read_index;
+
+        EVX_ENTROPY_STAT_BEGIN();
+        evx_status result = entropy_coder_decode_rans(coder, symbol_count, source, dest);
+        EVX_ENTROPY_STAT_END(coder);
+
+        entropy_coder_count_block(coder, dest, bin_offset, dest->write_index - bin_offset, source->read_index - stream_offset);
+
+        return result;
+    }
+
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+
+    //if (auto_start) 
+    //{
+        entropy_coder_prime_decoder(coder, &reader);
+    //}
+
+    if (EVX_SUCCESS != entropy_coder_decode_source(coder, symbol_count, &reader, &writer))
+    {
+        bitstream_reader_detach(&reader);
+        bitstream_writer_detach(&writer);
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    bitstream_reader_detach(&reader);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_start_decode(entropy_coder_t* coder, bitstream_t *source)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!source) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    /* The reader stays attached for decode_bin. We sync the source so that the
+       per symbol interface can also continue from here. */
+    bitstream_reader_attach(&coder->reader, source);
+    entropy_coder_prime_decoder(coder, &coder->reader);
+    bitstream_reader_sync(&coder->reader);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_finish_encode(entropy_coder_t* coder, bitstream_t *dest)
+{
+    if (coder->writer.stream && coder->writer.stream == dest)
+    {
+        /* Close out a session started by entropy_coder_start_encode. */
+        evx_status result = entropy_coder_flush_writer(coder, &coder->writer);
+
+        if (EVX_SUCCESS != bitstream_writer_detach(&coder->writer) || EVX_SUCCESS != result)
+        {
+            coder->writer.stream = 0;
+            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+        }
+
+        coder->writer.stream = 0;
+    }
+    else if (EVX_SUCCESS != entropy_coder_flush_encoder(coder, dest))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    entropy_coder_clear(coder);
+
+    return EVX_SUCCESS;
+}
+
+void entropy_context_init(entropy_context_t* contexts, uint32 count)
+{
+    for (uint32 i = 0; i < count; ++i)
+    {
+        contexts[i] = EVX_ENTROPY_PROBABILITY_HALF;
+    }
+}
+
+evx_status entropy_coder_bind_contexts(entropy_coder_t* coder, entropy_context_t* contexts, uint32 count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || (!contexts && count)) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    coder->contexts = contexts;
+    coder->context_count = count;
+
+    if (!coder->rate)
+    {
+        /* Contexts always adapt with the shift rule, whatever the coder's own model. */
+        coder->rate = EVX_ENTROPY_RATE_DEFAULT;
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_start_encode(entropy_coder_t* coder, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    entropy_coder_clear(coder);
+    bitstream_writer_attach(&coder->writer, dest);
+
+    return EVX_SUCCESS;
+}
+
+static evx_status entropy_coder_code_context(entropy_coder_t* coder, entropy_context_t *context, uint8 value)
+{
+    entropy_coder_split(coder, *context);
+    entropy_coder_code_bit(coder, value);
+    *context = (entropy_context_t) entropy_coder_adapt(*context, value, coder->rate);
+
+    return entropy_coder_scale_encoder(coder, &coder->writer);
+}
+
+static uint8 entropy_coder_resolve_context(entropy_coder_t* coder, entropy_context_t *context)
+{
+    entropy_coder_split(coder, *context);
+    uint8 bit = entropy_coder_resolve_bit(coder, coder->value);
+    *context = (entropy_context_t) entropy_coder_adapt(*context, bit, coder->rate);
+    entropy_coder_scale_decoder(coder, &coder->value, &coder->reader);
+
+    return bit;
+}
+
+evx_status entropy_coder_encode_bin(entropy_coder_t* coder, uint32 ctx_index, uint8 value)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (ctx_index >= coder->context_count || !coder->writer.stream) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    return entropy_coder_code_context(coder, &coder->contexts[ctx_index], value & 0x1);
+}
+
+uint8 entropy_coder_decode_bin(entropy_coder_t* coder, uint32 ctx_index)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (ctx_index >= coder->context_count || !coder->reader.stream) 
+        {
+            evx_post_error(EVX_ERROR_INVALIDARG);
+            return 0;
+        }
+    }
+
+    return entropy_coder_resolve_context(coder, &coder->contexts[ctx_index]);
+}
+
+evx_status entropy_coder_encode_run(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 run, uint32 max_run)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!ctx_count || run > max_run || !coder->writer.stream ||
+            ctx_base >= coder->context_count || ctx_count > coder->context_count - ctx_base) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    entropy_context_t *contexts = &coder->contexts[ctx_base];
+    uint32 last = ctx_count - 1;
+
+    for (uint32 i = 0; i < run; ++i)
+    {
+        if (EVX_SUCCESS != entropy_coder_code_context(coder, &contexts[evx_min2(i, last)], 1))
+        {
+            return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+        }
+    }
+
+    /* A run that reaches max_run is implicitly terminated. */
+    if (run < max_run && EVX_SUCCESS != entropy_coder_code_context(coder, &contexts[evx_min2(run, last)], 0))
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    return EVX_SUCCESS;
+}
+
+uint32 entropy_coder_decode_run(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 max_run)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!ctx_count || !coder->reader.stream ||
+            ctx_base >= coder->context_count || ctx_count > coder->context_count - ctx_base) 
+        {
+            evx_post_error(EVX_ERROR_INVALIDARG);
+            return 0;
+        }
+    }
+
+    entropy_context_t *contexts = &coder->contexts[ctx_base];
+    uint32 last = ctx_count - 1;
+    uint32 run = 0;
+
+    while (run < max_run && entropy_coder_resolve_context(coder, &contexts[evx_min2(run, last)]))
+    {
+        run++;
+    }
+
+    return run;
+}
+
+evx_status entropy_coder_encode_bypass(entropy_coder_t* coder, uint32 value, uint8 bit_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (bit_count > 32 || !coder->writer.stream) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    uint8 chunk_bits = (EVX_ENTROPY_ENGINE_RANGE == coder->engine) ? EVX_RANGE_BYPASS_BITS : EVX_ENTROPY_BYPASS_BITS;
+
+    while (bit_count)
+    {
+        uint8 count = evx_min2(bit_count, chunk_bits);
+        bit_count -= count;
+        EVX_ENTROPY_STAT_ADD(coder, bypass_bits, count);
+
+        /* Divide the interval into 2^count equal parts and select one. */
+        uint32 part = (uint32) ((value >> bit_count) & (((uint64) 0x1 << count) - 1));
+
+        if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+        {
+            coder->range >>= count;
+            coder->wide_low += (uint64) coder->range * part;
+        }
+        else
+        {
+            uint32 size = (coder->high - coder->low + 1) >> count;
+            coder->low += size * part;
+            coder->high = coder->low + size - 1;
+        }
+
+        if (EVX_SUCCESS != entropy_coder_scale_encoder(coder, &coder->writer))
+        {
+            return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+        }
+    }
+
+    return EVX_SUCCESS;
+}
+
+uint32 entropy_coder_decode_bypass(entropy_coder_t* coder, uint8 bit_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (bit_count > 32 || !coder->reader.stream) 
+        {
+            evx_post_error(EVX_ERROR_INVALIDARG);
+            return 0;
+        }
+    }
+
+    uint8 chunk_bits = (EVX_ENTROPY_ENGINE_RANGE == coder->engine) ? EVX_RANGE_BYPASS_BITS : EVX_ENTROPY_BYPASS_BITS;
+    uint32 result = 0;
+
+    while (bit_count)
+    {
+        uint8 count = evx_min2(bit_count, chunk_bits);
+        uint32 limit = ((uint32) 0x1 << count) - 1;
+        uint32 part = 0;
+        bit_count -= count;
+        EVX_ENTROPY_STAT_ADD(coder, bypass_bits, count);
+
+        if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+        {
+            coder->range >>= count;
+            part = evx_min2((coder->value - coder->low) / coder->range, limit);
+            coder->low += coder->range * part;
+        }
+        else
+        {
+            uint32 size = (coder->high - coder->low + 1) >> count;
+            part = evx_min2((coder->value - coder->low) / size, limit);
+            coder->low += size * part;
+            coder->high = coder->low + size - 1;
+        }
+
+        entropy_coder_scale_decoder(coder, &coder->value, &coder->reader);
+        result = (result << count) | part;
+    }
+
+    return result;
+}
+
+evx_status entropy_coder_encode_bits(entropy_coder_t* coder, uint32 value, uint8 bit_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (bit_count > 32 || !coder->writer.stream) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    /* Code LSB first with the coder's own model, exactly as entropy_coder_encode
+       codes its source. */
+    for (uint8 i = 0; i < bit_count; ++i, value >>= 1)
+    {
+        entropy_coder_encode_symbol(coder, value & 0x1);
+
+        if (EVX_SUCCESS != entropy_coder_scale_encoder(coder, &coder->writer))
+        {
+            return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+        }
+    }
+
+    return EVX_SUCCESS;
+}
+
+uint32 entropy_coder_decode_bits(entropy_coder_t* coder, uint8 bit_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (bit_count > 32 || !coder->reader.stream) 
+        {
+            evx_post_error(EVX_ERROR_INVALIDARG);
+            return 0;
+        }
+    }
+
+    uint32 result = 0;
+
+    for (uint8 i = 0; i < bit_count; ++i)
+    {
+        result |= (uint32) entropy_coder_decode_bit(coder, coder->value) << i;
+        entropy_coder_scale_decoder(coder, &coder->value, &coder->reader);
+    }
+
+    return result;
+}
+
+evx_status entropy_coder_encode_terminate(entropy_coder_t* coder, uint8 value)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder->writer.stream) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    entropy_coder_split(coder, EVX_ENTROPY_TERMINATE_PROBABILITY);
+    entropy_coder_code_bit(coder, value & 0x1);
+
+    return entropy_coder_scale_encoder(coder, &coder->writer);
+}
+
+uint8 entropy_coder_decode_terminate(entropy_coder_t* coder)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder->reader.stream) 
+        {
+            evx_post_error(EVX_ERROR_INVALIDARG);
+            return 1;
+        }
+    }
+
+    entropy_coder_split(coder, EVX_ENTROPY_TERMINATE_PROBABILITY);
+    uint8 bit = entropy_coder_resolve_bit(coder, coder->value);
+    entropy_coder_scale_decoder(coder, &coder->value, &coder->reader);
+
+    return bit;
+}
+
+void entropy_coder_finish_decode(entropy_coder_t* coder)
+{
+    if (coder->reader.stream)
+    {
+        bitstream_reader_detach(&coder->reader);
+        coder->reader.stream = 0;
+    }
+}
+
+static void entropy_coder_merge_stats(entropy_coder_t* coder, const entropy_coder_t* lane)
+{
+#if defined (EVX_ENTROPY_STATS)
+    coder->stats.bins += lane->stats.bins;
+    coder->stats.ones += lane->stats.ones;
+    coder->stats.bypass_bits += lane->stats.bypass_bits;
+    coder->stats.e1e2_shifts += lane->stats.e1e2_shifts;
+    coder->stats.e3_shifts += lane->stats.e3_shifts;
+    coder->stats.e3_run_max = evx_max2(coder->stats.e3_run_max, lane->stats.e3_run_max);
+    coder->stats.follow_bits += lane->stats.follow_bits;
+    coder->stats.byte_shifts += lane->stats.byte_shifts;
+    coder->stats.carries += lane->stats.carries;
+    coder->stats.stream_bits += lane->stats.stream_bits;
+    coder->stats.cycles += lane->stats.cycles;
+#else
+    (void) coder;
+    (void) lane;
+#endif
+}
+
+static uint8 entropy_coder_lane_byte(const bitstream_t *lane, uint64 *byte_index)
+{
+    /* A lane can end up to a byte short of what its decoder reads. The decoder
+       would see zero padding there in a stream of its own, so we emit that. */
+    uint64 index = (*byte_index)++;
+    return (index < (lane->write_index >> 3)) ? lane->data_store[index] : 0;
+}
+
+evx_status entropy_coder_encode_interleaved(entropy_coder_t* coder, uint8 lane_count, bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
 
-        entropy_coder_clear(coder);
+    /* Lanes only exist for the range engine, and a bad lane count would put 
+       the lanes out of step with the decoder, so neither is left to the 
+       parameter checks. */
+    if (EVX_ENTROPY_ENGINE_RANGE != coder->engine)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
 
-        /* We read in our initial bits with padded tailing zeroes. */
-        for (uint32 i = 0; i < EVX_ENTROPY_PRECISION; ++i) 
+    if (lane_count < EVX_ENTROPY_LANES_MIN || lane_count > EVX_ENTROPY_LANES_MAX)
+    {
+        return evx_post_error(EVX_ERROR_INVALIDARG);
+    }
+
+    entropy_coder_t lanes[EVX_ENTROPY_LANES_MAX];
+    bitstream_t lane_streams[EVX_ENTROPY_LANES_MAX];
+    bitstream_writer_t lane_writers[EVX_ENTROPY_LANES_MAX];
+    bitstream_t schedule;
+    bitstream_writer_t schedule_writer;
+    bitstream_reader_t reader;
+    evx_status result = EVX_SUCCESS;
+    uint64 remaining = bitstream_query_occupancy(source);
+    uint8 lane = 0;
+
+    /* Each lane codes every lane_count'th bin into a private buffer, and the 
+       schedule records which lane renormalized at every byte shift. */
+    bitstream_create_init(&schedule);
+    bitstream_set_growth(&schedule, 1);
+    bitstream_writer_attach(&schedule_writer, &schedule);
+
+    for (uint8 i = 0; i < lane_count; ++i)
+    {
+        lanes[i] = *coder;
+        entropy_coder_reset_range(&lanes[i]);
+        entropy_coder_reset_bindings(&lanes[i]);
+        entropy_coder_reset_stats(&lanes[i]);
+
+        bitstream_create_init(&lane_streams[i]);
+        bitstream_set_growth(&lane_streams[i], 1);
+
+        if (EVX_SUCCESS != bitstream_reserve(&lane_streams[i], entropy_coder_query_encode_bound(coder, remaining / lane_count + 1)))
+        {
+            result = EVX_ERROR_OUTOFMEMORY;
+        }
+
+        bitstream_writer_attach(&lane_writers[i], &lane_streams[i]);
+    }
+
+    bitstream_reader_attach(&reader, source);
+    EVX_ENTROPY_STAT_BEGIN();
+
+    while (remaining && EVX_SUCCESS == result) 
+    {
+        uint8 count = (uint8) evx_min2(remaining, 32);
+        uint32 bits = bitstream_reader_peek(&reader, count);
+        bitstream_reader_consume(&reader, count);
+        remaining -= count;
+
+        for (uint8 i = 0; i < count; ++i, bits >>= 1)
         {
-            if (!bitstream_is_empty(source))
+            entropy_coder_t *state = &lanes[lane];
+            entropy_coder_encode_symbol(state, bits & 0x1);
+
+            while (state->range < EVX_RANGE_TOP)
             {
-                if (EVX_SUCCESS != bitstream_read_bit(source, &bit))
+                state->range <<= 8;
+                EVX_ENTROPY_STAT_ADD(state, byte_shifts, 1);
+
+                if (EVX_SUCCESS != entropy_coder_shift_low(state, &lane_writers[lane]) ||
+                    EVX_SUCCESS != bitstream_writer_put_bits(&schedule_writer, lane, 8))
                 {
-                    return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+                    result = EVX_ERROR_CAPACITY_LIMIT;
                 }
             }
 
-            coder->value <<= 0x1;
-            coder->value |= bit;
+            lane = (lane + 1 == lane_count) ? 0 : lane + 1;
         }
-    //}
+    }
+
+    EVX_ENTROPY_STAT_END(coder);
+    bitstream_reader_detach(&reader);
 
-    /* Begin decoding the sequence. */
-    for (uint32 i = 0; i < symbol_count; ++i) 
+    for (uint8 i = 0; i < lane_count; ++i)
     {
-        if (EVX_SUCCESS != entropy_coder_decode_symbol(coder, coder->value, dest) ||
-            EVX_SUCCESS != entropy_coder_resolve_decode_scaling(coder, &(coder->value), source, dest))
+        if (EVX_SUCCESS != entropy_coder_flush_writer(&lanes[i], &lane_writers[i]) ||
+            EVX_SUCCESS != bitstream_writer_detach(&lane_writers[i]))
         {
-            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+            result = EVX_ERROR_CAPACITY_LIMIT;
+        }
+
+        entropy_coder_merge_stats(coder, &lanes[i]);
+    }
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&schedule_writer))
+    {
+        result = EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    if (EVX_SUCCESS == result)
+    {
+        /* Merge the lanes in the order the decoder will read them: each lane's
+           priming bytes, then one byte per scheduled shift. */
+        uint64 lane_bytes[EVX_ENTROPY_LANES_MAX] = {0};
+        uint64 schedule_length = schedule.write_index >> 3;
+        bitstream_writer_t writer;
+
+        bitstream_writer_attach(&writer, dest);
+
+        for (uint8 i = 0; i < lane_count && EVX_SUCCESS == result; ++i)
+        {
+            for (uint32 j = 0; j < EVX_RANGE_FLUSH_BYTES && EVX_SUCCESS == result; ++j)
+            {
+                result = bitstream_writer_put_bits(&writer, entropy_coder_lane_byte(&lane_streams[i], &lane_bytes[i]), 8);
+            }
+        }
+
+        for (uint64 i = 0; i < schedule_length && EVX_SUCCESS == result; ++i)
+        {
+            uint8 next = schedule.data_store[i];
+            result = bitstream_writer_put_bits(&writer, entropy_coder_lane_byte(&lane_streams[next], &lane_bytes[next]), 8);
+        }
+
+        if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+        {
+            result = EVX_ERROR_CAPACITY_LIMIT;
         }
     }
 
+    for (uint8 i = 0; i < lane_count; ++i)
+    {
+        bitstream_clear(&lane_streams[i]);
+    }
+
+    bitstream_clear(&schedule);
+    entropy_coder_clear(coder);
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
     return EVX_SUCCESS;
 }
 
-evx_status entropy_coder_start_decode(entropy_coder_t* coder, bitstream_t *source)
+evx_status entropy_coder_decode_interleaved(entropy_coder_t* coder, uint8 lane_count, uint64 symbol_count, bitstream_t *source, bitstream_t *dest)
 {
-    uint8 bit = 0;
-    coder->value = 0;
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || 0 == symbol_count || !source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANGE != coder->engine)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    if (lane_count < EVX_ENTROPY_LANES_MIN || lane_count > EVX_ENTROPY_LANES_MAX)
+    {
+        return evx_post_error(EVX_ERROR_INVALIDARG);
+    }
+
+    entropy_coder_t lanes[EVX_ENTROPY_LANES_MAX];
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+    uint8 lane = 0;
+
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+
+    /* The range state of every lane is kept in local arrays so that it can 
+       stay in registers. Only the count model needs the full coder state. */
+    uint32 range[EVX_ENTROPY_LANES_MAX];
+    uint32 low[EVX_ENTROPY_LANES_MAX];
+    uint32 value[EVX_ENTROPY_LANES_MAX];
+    uint32 model[EVX_ENTROPY_LANES_MAX];
+
+    for (uint8 i = 0; i < lane_count; ++i)
+    {
+        lanes[i] = *coder;
+        entropy_coder_reset_bindings(&lanes[i]);
+        entropy_coder_reset_stats(&lanes[i]);
+        entropy_coder_prime_decoder(&lanes[i], &reader);
+
+        range[i] = lanes[i].range;
+        low[i] = lanes[i].low;
+        value[i] = lanes[i].value;
+        model[i] = (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive) ? lanes[i].model : entropy_coder_query_probability(&lanes[i]);
+    }
+
+    /* Consecutive bins belong to different lanes and share no state other than
+       the input, so their dependency chains overlap in the pipeline. Decisions
+       are made without data dependent branches: interleaved bins are poorly 
+       predictable, and a mispredict per bin would cost more than the lanes 
+       save. */
+    EVX_ENTROPY_STAT_BEGIN();
+
+    for (uint64 i = 0; i < symbol_count;) 
+    {
+        uint8 count = (uint8) evx_min2(symbol_count - i, 32);
+        uint32 bits = 0;
+
+        for (uint8 j = 0; j < count; ++j)
+        {
+            uint32 probability = model[lane];
+            uint32 mid = (range[lane] >> EVX_ENTROPY_PROBABILITY_BITS) * probability;
+            uint8 bit = (value[lane] - low[lane]) >= mid;
+            uint32 mask = 0 - (uint32) bit;
+
+            low[lane] += mid & mask;
+            range[lane] = mid + ((range[lane] - mid - mid) & mask);
+            bits |= (uint32) bit << j;
+            EVX_ENTROPY_STAT_ADD(coder, ones, bit);
+
+            if (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive)
+            {
+                uint32 zero = entropy_coder_adapt(probability, 0, coder->rate);
+                uint32 one = entropy_coder_adapt(probability, 1, coder->rate);
+                model[lane] = zero + ((one - zero) & mask);
+            }
+            else if (EVX_ENTROPY_MODEL_COUNT == coder->adaptive)
+            {
+                entropy_coder_update_model(&lanes[lane], bit);
+                model[lane] = entropy_coder_query_probability(&lanes[lane]);
+            }
+
+            while (range[lane] < EVX_RANGE_TOP)
+            {
+                range[lane] <<= 8;
+                low[lane] <<= 8;
+                value[lane] = (value[lane] << 8) | bitstream_reader_peek(&reader, 8);
+                bitstream_reader_consume(&reader, 8);
+                EVX_ENTROPY_STAT_ADD(coder, byte_shifts, 1);
+                EVX_ENTROPY_STAT_ADD(coder, stream_bits, 8);
+            }
+
+            lane = (lane + 1 == lane_count) ? 0 : lane + 1;
+        }
+
+        if (EVX_SUCCESS != bitstream_writer_put_bits(&writer, bits, count))
+        {
+            bitstream_reader_detach(&reader);
+            bitstream_writer_detach(&writer);
+            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+        }
+
+        i += count;
+        EVX_ENTROPY_STAT_ADD(coder, bins, count);
+    }
+
+    EVX_ENTROPY_STAT_END(coder);
+
+    for (uint8 i = 0; i < lane_count; ++i)
+    {
+        entropy_coder_merge_stats(coder, &lanes[i]);
+    }
 
+    bitstream_reader_detach(&reader);
     entropy_coder_clear(coder);
 
-    /* We read in our initial bits with padded tailing zeroes. */
-    for (uint32 i = 0; i < EVX_ENTROPY_PRECISION; ++i) 
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_encode_terminated(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_SUCCESS != entropy_coder_start_encode(coder, dest))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    const uint64 block_bins = (uint64) 0x1 << EVX_ENTROPY_TERMINATE_BLOCK_BITS;
+    uint64 remaining = bitstream_query_occupancy(source);
+    evx_status result = EVX_SUCCESS;
+    bitstream_reader_t reader;
+    bitstream_reader_attach(&reader, source);
+    EVX_ENTROPY_STAT_BEGIN();
+
+    while (EVX_SUCCESS == result)
+    {
+        uint64 block = evx_min2(remaining, block_bins);
+        uint8 last = (block < block_bins);
+
+        result = entropy_coder_encode_terminate(coder, last);
+
+        if (last && EVX_SUCCESS == result)
+        {
+            result = entropy_coder_encode_bypass(coder, (uint32) block, EVX_ENTROPY_TERMINATE_BLOCK_BITS);
+        }
+
+        for (uint64 i = 0; i < block && EVX_SUCCESS == result; i += 32)
+        {
+            uint8 count = (uint8) evx_min2(block - i, 32);
+            result = entropy_coder_encode_bits(coder, bitstream_reader_peek(&reader, count), count);
+            bitstream_reader_consume(&reader, count);
+        }
+
+        remaining -= block;
+
+        if (last)
+        {
+            break;
+        }
+    }
+
+    EVX_ENTROPY_STAT_END(coder);
+    bitstream_reader_detach(&reader);
+
+    if (EVX_SUCCESS != entropy_coder_finish_encode(coder, dest) || EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_decode_terminated(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_SUCCESS != entropy_coder_start_decode(coder, source))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    const uint64 block_bins = (uint64) 0x1 << EVX_ENTROPY_TERMINATE_BLOCK_BITS;
+    bitstream_reader_t *reader = &coder->reader;
+    bitstream_writer_t writer;
+    bitstream_writer_attach(&writer, dest);
+    EVX_ENTROPY_STAT_BEGIN();
+
+    while (1)
     {
-        if (!bitstream_is_empty(source))
+        uint64 block = block_bins;
+        uint8 last = entropy_coder_decode_terminate(coder);
+
+        if (last)
+        {
+            block = entropy_coder_decode_bypass(coder, EVX_ENTROPY_TERMINATE_BLOCK_BITS);
+        }
+
+        /* A damaged or truncated codeword may never terminate. The decoder only 
+           reads ahead of the flushed codeword by its own window, so anything 
+           further means the end marker has been lost. */
+        if (reader->fill_index - reader->window_bits > reader->end_index + (EVX_RANGE_FLUSH_BYTES << 3) + 64)
+        {
+            entropy_coder_finish_decode(coder);
+            bitstream_writer_detach(&writer);
+            return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+        }
+
+        /* The block itself is decoded exactly as entropy_coder_decode would. */
+        for (uint64 i = 0; i < block; ++i)
         {
-            if (EVX_SUCCESS != bitstream_read_bit(source, &bit))
+            if (EVX_SUCCESS != bitstream_writer_put_bit(&writer, entropy_coder_decode_bit(coder, coder->value)))
             {
-                return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+                entropy_coder_finish_decode(coder);
+                bitstream_writer_detach(&writer);
+                return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
             }
+
+            entropy_coder_scale_decoder(coder, &coder->value, reader);
         }
 
-        coder->value <<= 0x1;
-        coder->value |= bit;
+        if (last)
+        {
+            break;
+        }
+    }
+
+    EVX_ENTROPY_STAT_END(coder);
+    entropy_coder_finish_decode(coder);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
     }
 
     return EVX_SUCCESS;
 }
 
-evx_status entropy_coder_finish_encode(entropy_coder_t* coder, bitstream_t *dest)
+uint64 entropy_coder_query_checkpoint_count(uint64 bit_count, uint64 interval)
+{
+    if (0 == interval)
+    {
+        return 0;
+    }
+
+    return bit_count / interval + (0 != bit_count % interval);
+}
+
+static void entropy_coder_save_checkpoint(const entropy_coder_t* coder, uint64 symbol_index, uint64 bits_written, entropy_checkpoint_t *checkpoint)
 {
-    if (EVX_SUCCESS != entropy_coder_flush_encoder(coder, dest))
+    checkpoint->symbol_index = symbol_index;
+    checkpoint->e3_count = coder->e3_count;
+    checkpoint->model = coder->model;
+    checkpoint->history[0] = coder->history[0];
+    checkpoint->history[1] = coder->history[1];
+
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        /* Each shift moved one byte of low into the written or cached bytes. The
+           decoder's low wraps at 32 bits, and its value window starts one byte 
+           past the leading zero. */
+        checkpoint->bit_offset = bits_written + (coder->cache_size << 3);
+        checkpoint->low = (uint32) coder->wide_low;
+        checkpoint->high = coder->range;
+        return;
+    }
+
+    /* Each shift either wrote a bit or deferred one as a follow bit. */
+    checkpoint->bit_offset = bits_written + coder->e3_count;
+    checkpoint->low = coder->low;
+    checkpoint->high = coder->high;
+}
+
+evx_status entropy_coder_encode_checkpointed(entropy_coder_t* coder, uint64 interval, bitstream_t *source, bitstream_t *dest, 
+                                             entropy_checkpoint_t *checkpoints, uint64 checkpoint_count)
+{
+    uint64 bit_count = bitstream_query_occupancy(source);
+
+    if (EVX_PARAM_CHECK) 
+    {
+        if (0 == interval || !source || !dest || !checkpoints ||
+            checkpoint_count < entropy_coder_query_checkpoint_count(bit_count, interval)) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        /* rANS codes in reverse, so its state at a bin is not known until the end. */
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+
+    uint64 start = dest->write_index;
+
+    for (uint64 i = 0; i < bit_count; i += interval)
+    {
+        uint64 bits_written = (writer.byte_index << 3) + writer.cache_bits - start;
+        entropy_coder_save_checkpoint(coder, i, bits_written, checkpoints++);
+
+        if (EVX_SUCCESS != entropy_coder_encode_source(coder, evx_min2(interval, bit_count - i), &reader, &writer))
+        {
+            bitstream_reader_detach(&reader);
+            bitstream_writer_detach(&writer);
+            return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+        }
+    }
+
+    bitstream_reader_detach(&reader);
+
+    if (EVX_SUCCESS != entropy_coder_flush_writer(coder, &writer) ||
+        EVX_SUCCESS != bitstream_writer_detach(&writer)) 
     {
         return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
     }
@@ -430,3 +1895,87 @@ evx_status entropy_coder_finish_encode(entropy_coder_t* coder, bitstream_t *dest
 
     return EVX_SUCCESS;
 }
+
+evx_status entropy_coder_decode_checkpoint(entropy_coder_t* coder, const entropy_checkpoint_t *checkpoint, uint64 symbol_count, 
+                                           bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!checkpoint || 0 == symbol_count || !source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    /* The source read index marks the start of the codeword. It is restored 
+       on return so that any number of lookups can share the same source. */
+    uint64 codeword_start = source->read_index;
+    bitstream_seek(source, codeword_start + checkpoint->bit_offset);
+
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+
+    entropy_coder_clear(coder);
+    coder->low = checkpoint->low;
+    coder->model = checkpoint->model;
+    coder->history[0] = checkpoint->history[0];
+    coder->history[1] = checkpoint->history[1];
+
+    if (EVX_ENTROPY_ENGINE_RANGE == coder->engine)
+    {
+        coder->range = checkpoint->high;
+
+        /* The window is the four bytes that follow the byte at the top of low. */
+        for (uint32 i = 1; i < EVX_RANGE_FLUSH_BYTES; ++i) 
+        {
+            coder->value = (coder->value << 8) | bitstream_reader_peek(&reader, 8);
+            bitstream_reader_consume(&reader, 8);
+        }
+
+        EVX_ENTROPY_STAT_ADD(coder, stream_bits, (EVX_RANGE_FLUSH_BYTES - 1) << 3);
+    }
+    else
+    {
+        coder->high = checkpoint->high;
+
+        for (uint32 i = 0; i < EVX_ENTROPY_PRECISION; ++i) 
+        {
+            coder->value = (coder->value << 0x1) | bitstream_reader_read_bit(&reader);
+        }
+
+        EVX_ENTROPY_STAT_ADD(coder, stream_bits, EVX_ENTROPY_PRECISION);
+
+        /* Pending follow bits mean the last shift was an E3 shift, which moved 
+           low, high and value down by a half. Older shifts have since wrapped
+           out of the window. */
+        if (checkpoint->e3_count)
+        {
+            coder->value = (coder->value - (EVX_ENTROPY_HALF_RANGE + 1)) & EVX_ENTROPY_PRECISION_MAX;
+        }
+    }
+
+    if (EVX_SUCCESS != entropy_coder_decode_source(coder, symbol_count, &reader, &writer))
+    {
+        bitstream_reader_detach(&reader);
+        bitstream_writer_detach(&writer);
+        source->read_index = codeword_start;
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    bitstream_reader_detach(&reader);
+    source->read_index = codeword_start;
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    return EVX_SUCCESS;
+}
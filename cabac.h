@@ -60,22 +60,261 @@
 #define EVX_MB                  (EVX_KB * EVX_KB)
 #define EVX_GB                  (EVX_MB * EVX_KB)
 
+/*
+// Probability Models
+//
+//  o: EVX_ENTROPY_MODEL_STATIC
+//
+//     A fixed probability supplied to entropy_coder_init2.
+//
+//  o: EVX_ENTROPY_MODEL_COUNT
+//
+//     The probability of a zero is history[0] / (history[0] + history[1]). This
+//     is the most accurate estimate but it requires a divide for every symbol.
+//
+//  o: EVX_ENTROPY_MODEL_SHIFT
+//
+//     The probability of a zero is held as a 16 bit fixed point value in model, 
+//     and is moved toward each coded symbol by 1/2^rate. Resolving the model only 
+//     requires a multiply and a shift. Smaller rates adapt faster, larger rates
+//     settle on a more precise estimate.
+//
+// Every codeword starts from the coder's initial model. This is the 
+// uninformed default set by the init functions, unless the coder was 
+// loaded from a model pack (see pack_cabac.h).
+*/
+
+#define EVX_ENTROPY_MODEL_STATIC                (0)
+#define EVX_ENTROPY_MODEL_COUNT                 (1)
+#define EVX_ENTROPY_MODEL_SHIFT                 (2)
+
+#define EVX_ENTROPY_PROBABILITY_BITS            (16)
+#define EVX_ENTROPY_PROBABILITY_ONE             ((uint32)0x1 << EVX_ENTROPY_PROBABILITY_BITS)
+#define EVX_ENTROPY_PROBABILITY_HALF            (EVX_ENTROPY_PROBABILITY_ONE >> 1)
+
+/*
+// Coding Engines
+//
+//  o: EVX_ENTROPY_ENGINE_ARITHMETIC
+//
+//     The default 16 bit binary arithmetic coder. It renormalizes one bit at a 
+//     time and tracks E3 follow bits.
+//
+//  o: EVX_ENTROPY_ENGINE_RANGE
+//
+//     A 32 bit range coder that renormalizes whole bytes. Pending carries are 
+//     held in a wide low register and a cached byte run, so there is no follow
+//     bit bookkeeping.
+//
+//  o: EVX_ENTROPY_ENGINE_RANS
+//
+//     A binary rANS coder with a 64 bit state (see rans_cabac.h). Decoding is
+//     the cheapest of the three engines, but the encoder buffers bins and 
+//     codes them in reverse, so only entropy_coder_encode and decode support
+//     it. The per symbol and context interfaces return EVX_ERROR_NOTIMPL.
+//
+// Select an engine with entropy_coder_select_engine after init. Every engine
+// supports every probability model.
+*/
+
+#define EVX_ENTROPY_ENGINE_ARITHMETIC           (0)
+#define EVX_ENTROPY_ENGINE_RANGE                (1)
+#define EVX_ENTROPY_ENGINE_RANS                 (2)
+
+/* The range engine renormalizes a byte at a time whenever its range drops 
+   below EVX_RANGE_TOP, and its decoder primes with EVX_RANGE_FLUSH_BYTES. */
+#define EVX_RANGE_TOP                           ((uint32)0x1 << 24)
+#define EVX_RANGE_FLUSH_BYTES                   (5)
+
+/* When either count reaches this limit both are halved, so a counting model
+   can code streams of any length while it keeps tracking recent statistics. */
+#define EVX_ENTROPY_HISTORY_LIMIT               (2 * EVX_GB)
+
+#define EVX_ENTROPY_RATE_MIN                    (1)
+#define EVX_ENTROPY_RATE_MAX                    (12)
+#define EVX_ENTROPY_RATE_DEFAULT                (5)
+
+#define EVX_ENTROPY_LANES_MIN                   (2)
+#define EVX_ENTROPY_LANES_MAX                   (8)
+
+/*
+// Terminated Streams
+//
+// entropy_coder_encode_terminated produces a codeword that carries its own 
+// length, so entropy_coder_decode_terminated needs no symbol count. The source
+// is coded in blocks of 2^EVX_ENTROPY_TERMINATE_BLOCK_BITS symbols, and every
+// block is preceded by a terminate bin: 0 for a full block, or 1 followed by 
+// the length of the final (possibly empty) block in bypass bits. The decoder 
+// checks for the end once per block and decodes full blocks unchecked.
+//
+// Terminate bins are coded with the fixed probability 
+// EVX_ENTROPY_TERMINATE_PROBABILITY, so a 0 costs about 0.0014 bits, which 
+// is less than a millionth of a bit per symbol. They may also be coded in a 
+// session with encode_terminate/decode_terminate to mark the end of any 
+// context coded syntax.
+*/
+
+#define EVX_ENTROPY_TERMINATE_BLOCK_BITS        (12)
+#define EVX_ENTROPY_TERMINATE_PROBABILITY       (EVX_ENTROPY_PROBABILITY_ONE - 64)
+
+/*
+// Context Coding
+//
+// A coder may drive any number of caller owned context states through a single
+// codeword. Each context is the 16 bit probability of a zero and adapts with 
+// the shift rule at the coder's rate, so 32K contexts occupy 64 KB. To code 
+// with contexts:
+//
+//  1. Initialize the array with entropy_context_init and attach it with 
+//     entropy_coder_bind_contexts.
+//
+//  2. Encode: entropy_coder_start_encode, any number of encode_bin calls, 
+//     then entropy_coder_finish_encode.
+//
+//  3. Decode: entropy_coder_start_decode, the same sequence of decode_bin 
+//     calls, then entropy_coder_finish_decode to update the source read index.
+//
+// Both sessions keep their bitstream attached to the coder, so the stream must
+// not be touched by other calls until the session is finished.
+//
+// Bits that are effectively random may be coded with encode_bypass/decode_bypass
+// instead. These skip the model entirely and code up to 32 bits per call, MSB 
+// first, by splitting the interval into equal parts several bits at a time.
+*/
+
+/*
+// Interleaved Coding
+//
+// entropy_coder_encode_interleaved deals the source bits round robin to 2-8
+// independent lanes, each a copy of the coder with its own model and range 
+// state. Lane i codes bins i, i + lane_count, and so on. Because no lane 
+// depends on the previous bin, the decoder can overlap the lanes' dependency 
+// chains instead of waiting on one long serial chain.
+//
+// The lanes share one output buffer. Bytes are stored in exactly the order the
+// decoder consumes them: the priming bytes of lane 0, 1, ..., then one byte for 
+// every renormalizing shift in bin order. Interleaving requires the range 
+// engine, and the decoder must use the same lane count as the encoder. Other
+// engines return EVX_ERROR_NOTIMPL and lane counts outside 
+// [EVX_ENTROPY_LANES_MIN, EVX_ENTROPY_LANES_MAX] return EVX_ERROR_INVALIDARG.
+*/
+
+/*
+// Statistics
+//
+// When EVX_ENTROPY_STATS is defined, every coder carries a block of counters 
+// describing the work its engine has done: bins and their values, bypass bits,
+// renormalizations, follow bits, carries and stream bits. Without the define
+// the block and every update to it compile away, and entropy_coder_query_stats
+// returns EVX_ERROR_NOTIMPL.
+//
+// The counters accumulate across calls until entropy_coder_reset_stats or an 
+// init function clears them. A long e3_run_max is the signature of a stream 
+// that keeps its interval straddling the midpoint, which costs follow bits 
+// and throughput. Cycles are read from the time stamp counter around the bin
+// loops of the whole buffer calls, and stay zero on other platforms. Parallel
+// and batch coders work on copies of the coder, so they are not counted.
+*/
+
+typedef struct
+{
+  uint64 bins;
+  uint64 zeros;
+  uint64 ones;
+  uint64 bypass_bits;
+
+  /* Arithmetic engine renormalizations. e3_run is the current run of E3 
+     shifts, and e3_run_max the longest seen. */
+  uint64 e1e2_shifts;
+  uint64 e3_shifts;
+  uint64 e3_run;
+  uint64 e3_run_max;
+  uint64 follow_bits;
+
+  /* Range engine renormalizations. */
+  uint64 byte_shifts;
+  uint64 carries;
+
+  /* Bits written by an encoder or read by a decoder. */
+  uint64 stream_bits;
+  uint64 cycles;
+} entropy_coder_stats_t;
+
+typedef uint16 entropy_context_t;
 
 typedef struct
 {
   uint8 adaptive;
-  uint32 e3_count;
+  uint8 rate;
+  uint8 engine;
+  uint64 e3_count;
   uint32 history[2];
   uint32 value;
 
+  /* The model that entropy_coder_clear restores. init1, init2 and init3 set
+     the uninformed defaults and a model pack replaces them with trained ones. */
+  uint32 initial_model;
+  uint32 initial_history[2];
+
   uint32 model;
   uint32 low;
   uint32 high;
   uint32 mid;
+
+  /* Range engine state. The decoder uses low, range and value. */
+  uint64 wide_low;
+  uint32 range;
+  uint64 cache_size;
+  uint8 cache;
+
+  /* Context coding state. */
+  entropy_context_t* contexts;
+  uint32 context_count;
+  bitstream_writer_t writer;
+  bitstream_reader_t reader;
+
+#if defined (EVX_ENTROPY_STATS)
+  entropy_coder_stats_t stats;
+#endif
 } entropy_coder_t;
 
+/*
+// Checkpoints
+//
+// entropy_coder_encode_checkpointed records the decoder's state every interval
+// bins while it codes a single codeword, and entropy_coder_decode_checkpoint 
+// resumes decoding at any of them, so a lookup deep inside a long codeword 
+// costs at most interval bins instead of a decode from the start.
+//
+// A checkpoint holds the interval (low and high, or low and range), the model
+// (model and history) and the offset of the decoder's value window from the 
+// start of the codeword. The window itself is read back from the codeword on 
+// resume. The arithmetic decoder applies its E3 offset to the window when the
+// encoder had follow bits pending, which is all it needs from e3_count.
+//
+// Checkpoint i is taken before bin i * interval, so checkpoint 0 is the state
+// after priming. Checkpoints are not available for the rANS engine.
+//
+// entropy_coder_decode_checkpoint takes the source's read index as the start
+// of the codeword and leaves it unchanged, so one source can serve any number
+// of lookups.
+*/
+
+typedef struct
+{
+  uint64 symbol_index;
+  uint64 bit_offset;
+  uint64 e3_count;
+  uint32 low;
+  uint32 high;
+  uint32 model;
+  uint32 history[2];
+} entropy_checkpoint_t;
+
 
+uint32 entropy_coder_query_probability(const entropy_coder_t* coder);
 void entropy_coder_resolve_model(entropy_coder_t* coder);
+void entropy_coder_update_model(entropy_coder_t* coder, uint8 value);
 
 evx_status entropy_coder_flush_encoder(entropy_coder_t* coder, bitstream_t *dest);
 evx_status entropy_coder_flush_inverse_bits(entropy_coder_t* coder, uint8 value, bitstream_t *dest);
@@ -89,14 +328,59 @@ evx_status entropy_coder_resolve_decode_scaling(entropy_coder_t* coder, uint32 *
 
 void entropy_coder_init1(entropy_coder_t* coder);
 void entropy_coder_init2(entropy_coder_t* coder, uint32 input_model);
+void entropy_coder_init3(entropy_coder_t* coder, uint8 rate);
 void entropy_coder_clear(entropy_coder_t* coder);
+evx_status entropy_coder_select_engine(entropy_coder_t* coder, uint8 engine);
+
+evx_status entropy_coder_query_stats(const entropy_coder_t* coder, entropy_coder_stats_t *stats);
+void entropy_coder_reset_stats(entropy_coder_t* coder);
+
+/* Returns the worst case number of bytes that entropy_coder_encode can append
+   to dest when coding bit_count source bits with this coder's configuration. */
+uint64 entropy_coder_query_encode_bound(const entropy_coder_t* coder, uint64 bit_count);
 
 evx_status entropy_coder_encode(entropy_coder_t* coder, bitstream_t *source, bitstream_t* dest);
-evx_status entropy_coder_decode(entropy_coder_t* coder, uint32 symbol_count, bitstream_t *source, bitstream_t *dest);
+evx_status entropy_coder_decode(entropy_coder_t* coder, uint64 symbol_count, bitstream_t *source, bitstream_t *dest);
 
 evx_status entropy_coder_start_decode(entropy_coder_t* coder, bitstream_t *source);
 evx_status entropy_coder_finish_encode(entropy_coder_t* coder, bitstream_t *dest);
 
+void entropy_context_init(entropy_context_t* contexts, uint32 count);
+evx_status entropy_coder_bind_contexts(entropy_coder_t* coder, entropy_context_t* contexts, uint32 count);
+
+evx_status entropy_coder_start_encode(entropy_coder_t* coder, bitstream_t *dest);
+evx_status entropy_coder_encode_bin(entropy_coder_t* coder, uint32 ctx_index, uint8 value);
+uint8 entropy_coder_decode_bin(entropy_coder_t* coder, uint32 ctx_index);
+evx_status entropy_coder_encode_bypass(entropy_coder_t* coder, uint32 value, uint8 bit_count);
+uint32 entropy_coder_decode_bypass(entropy_coder_t* coder, uint8 bit_count);
+
+/* Codes up to 32 bits LSB first with the coder's own model rather than a bound 
+   context, producing the same codeword as entropy_coder_encode. */
+evx_status entropy_coder_encode_bits(entropy_coder_t* coder, uint32 value, uint8 bit_count);
+uint32 entropy_coder_decode_bits(entropy_coder_t* coder, uint8 bit_count);
+evx_status entropy_coder_encode_terminate(entropy_coder_t* coder, uint8 value);
+uint8 entropy_coder_decode_terminate(entropy_coder_t* coder);
+
+/* Codes run ones followed by a terminating zero (omitted when run == max_run). 
+   Bin i uses context ctx_base + min(i, ctx_count - 1). */
+evx_status entropy_coder_encode_run(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 run, uint32 max_run);
+uint32 entropy_coder_decode_run(entropy_coder_t* coder, uint32 ctx_base, uint32 ctx_count, uint32 max_run);
+void entropy_coder_finish_decode(entropy_coder_t* coder);
+
+evx_status entropy_coder_encode_interleaved(entropy_coder_t* coder, uint8 lane_count, bitstream_t *source, bitstream_t *dest);
+evx_status entropy_coder_decode_interleaved(entropy_coder_t* coder, uint8 lane_count, uint64 symbol_count, bitstream_t *source, bitstream_t *dest);
+
+evx_status entropy_coder_encode_terminated(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest);
+evx_status entropy_coder_decode_terminated(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest);
+
+/* Returns the number of checkpoints taken while coding bit_count bins. */
+uint64 entropy_coder_query_checkpoint_count(uint64 bit_count, uint64 interval);
+
+evx_status entropy_coder_encode_checkpointed(entropy_coder_t* coder, uint64 interval, bitstream_t *source, bitstream_t *dest, 
+                                             entropy_checkpoint_t *checkpoints, uint64 checkpoint_count);
+evx_status entropy_coder_decode_checkpoint(entropy_coder_t* coder, const entropy_checkpoint_t *checkpoint, uint64 symbol_count, 
+                                           bitstream_t *source, bitstream_t *dest);
+
 
 
 #endif // __EVX_CABAC_H__
\ No newline at end of file
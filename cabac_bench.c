@@ -0,0 +1,610 @@
+
+#include "cabac.h"
+
+#if defined (EVX_PLATFORM_WINDOWS)
+    #error "cabac_bench requires a POSIX platform (clock_gettime)."
+#endif
+
+#include "math.h"
+#include "time.h"
+
+/*
+// cabac_bench
+//
+// Measures entropy_coder_encode and entropy_coder_decode on a fixed set of
+// synthetic sources, and on any files named on the command line:
+//
+//   cabac_bench [-e arithmetic|range|rans] [-m shift|count] [-r rate]
+//               [-n bytes] [-i iterations] [file ...]
+//
+// Every engine is measured unless -e selects one. The sources are:
+//
+//   bernoulli_p*   independent bits that are one with probability p
+//   markov_s*      a two state chain that repeats its last bit with probability s
+//   zeros          all zero bits
+//   random         uniformly random bytes
+//   text           generated English words, plus the named files
+//
+// Each throughput result is the fastest of the iterations and is checked by
+// comparing the decoded bits with the source. bits_per_bin is compared with
+// the entropy of the source: the entropy rate of the generating process when
+// it is known, otherwise the order 0 entropy of the bits.
+//
+// Latency is measured separately for small messages coded one at a time with
+// a freshly initialized coder, as a service coding individual records would.
+//
+// Results are written to stdout as a single JSON object so that runs can be
+// compared across versions. Progress and errors go to stderr.
+*/
+
+#define EVX_BENCH_SCHEMA                (1)
+#define EVX_BENCH_BYTES_DEFAULT         (1 * EVX_MB)
+#define EVX_BENCH_ITERATIONS_DEFAULT    (5)
+#define EVX_BENCH_MESSAGE_COUNT         (10000)
+#define EVX_BENCH_INPUTS_MAX            (64)
+#define EVX_BENCH_SEED                  (0x9E3779B97F4A7C15ull)
+
+typedef struct
+{
+    char name[64];
+    const char *kind;
+    double entropy;
+    bitstream_t bits;
+} cabac_bench_input_t;
+
+typedef struct
+{
+    uint8 engine;
+    uint8 model;
+    uint8 rate;
+    uint32 iterations;
+} cabac_bench_config_t;
+
+static const char *cabac_bench_engine_names[] = {"arithmetic", "range", "rans"};
+static const char *cabac_bench_model_names[] = {"static", "count", "shift"};
+
+static const double cabac_bench_bernoulli[] = {0.25, 0.1, 0.05, 0.01, 0.001};
+static const double cabac_bench_markov[] = {0.9, 0.99};
+static const uint32 cabac_bench_message_bytes[] = {16, 64, 256, 1024};
+
+static const char *cabac_bench_words[] =
+{
+    "the", "of", "and", "to", "a", "in", "is", "that", "for", "it", "as", "was",
+    "with", "be", "by", "on", "not", "he", "this", "are", "or", "his", "from",
+    "at", "which", "but", "have", "an", "had", "they", "you", "were", "their",
+    "one", "all", "we", "can", "her", "has", "there", "been", "if", "more",
+    "when", "will", "would", "who", "so", "no", "coder", "stream", "symbol",
+    "model", "range", "probability", "interval", "context", "decoder", "encoder"
+};
+
+static uint64 cabac_bench_state = EVX_BENCH_SEED;
+
+static uint64 cabac_bench_random()
+{
+    /* xorshift64*, so every run measures exactly the same sources. */
+    cabac_bench_state ^= cabac_bench_state >> 12;
+    cabac_bench_state ^= cabac_bench_state << 25;
+    cabac_bench_state ^= cabac_bench_state >> 27;
+
+    return cabac_bench_state * 0x2545F4914F6CDD1Dull;
+}
+
+static double cabac_bench_random_unit()
+{
+    return (double) (cabac_bench_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double cabac_bench_query_time()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+static double cabac_bench_binary_entropy(double p)
+{
+    if (p <= 0.0 || p >= 1.0)
+    {
+        return 0.0;
+    }
+
+    return -p * log2(p) - (1.0 - p) * log2(1.0 - p);
+}
+
+static double cabac_bench_order0_entropy(bitstream_t *bits)
+{
+    uint64 count = bitstream_query_occupancy(bits);
+    uint64 ones = 0;
+
+    if (!count)
+    {
+        return 0.0;
+    }
+
+    for (uint64 i = 0; i < (count >> 3); ++i)
+    {
+        ones += __builtin_popcount(bits->data_store[i]);
+    }
+
+    for (uint64 i = count & ~(uint64) 7; i < count; ++i)
+    {
+        ones += (bits->data_store[i >> 3] >> (i & 7)) & 0x1;
+    }
+
+    return cabac_bench_binary_entropy((double) ones / (double) count);
+}
+
+static cabac_bench_input_t *cabac_bench_add_input(cabac_bench_input_t *inputs, uint32 *count, const char *kind, uint64 byte_count)
+{
+    if (*count >= EVX_BENCH_INPUTS_MAX)
+    {
+        return 0;
+    }
+
+    cabac_bench_input_t *input = &inputs[(*count)++];
+    memset(input, 0, sizeof(cabac_bench_input_t));
+    input->kind = kind;
+    bitstream_create_new(&input->bits, evx_max2(byte_count, 1) << 3);
+
+    return input;
+}
+
+static void cabac_bench_fill_bits(bitstream_t *bits, uint64 byte_count, double p, double stay)
+{
+    bitstream_writer_t writer;
+    bitstream_writer_attach(&writer, bits);
+    uint8 bit = 0;
+
+    for (uint64 i = 0; i < (byte_count << 3); ++i)
+    {
+        if (stay > 0.0)
+        {
+            bit = (cabac_bench_random_unit() < stay) ? bit : !bit;
+        }
+        else
+        {
+            bit = (cabac_bench_random_unit() < p);
+        }
+
+        bitstream_writer_put_bit(&writer, bit);
+    }
+
+    bitstream_writer_detach(&writer);
+}
+
+static void cabac_bench_fill_text(cabac_bench_input_t *input, uint64 byte_count)
+{
+    const uint32 word_count = sizeof(cabac_bench_words) / sizeof(cabac_bench_words[0]);
+    uint8 *text = (uint8 *) malloc(byte_count + 32);
+    uint64 length = 0;
+
+    while (length < byte_count)
+    {
+        /* Squaring a uniform variate favours the common words at the front. */
+        double u = cabac_bench_random_unit();
+        const char *word = cabac_bench_words[(uint32) (u * u * word_count)];
+        uint32 word_length = (uint32) strlen(word);
+
+        memcpy(text + length, word, word_length);
+        length += word_length;
+        text[length++] = (cabac_bench_random() % 12) ? ' ' : ((cabac_bench_random() & 1) ? '.' : '\n');
+    }
+
+    bitstream_write_bytes(&input->bits, text, byte_count);
+    free(text);
+}
+
+static evx_status cabac_bench_load_file(cabac_bench_input_t *inputs, uint32 *count, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (!file)
+    {
+        fprintf(stderr, "cabac_bench: cannot open %s\n", path);
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    cabac_bench_input_t *input = (size > 0) ? cabac_bench_add_input(inputs, count, "order0", (uint64) size) : 0;
+
+    if (!input)
+    {
+        fclose(file);
+        fprintf(stderr, "cabac_bench: cannot use %s\n", path);
+        return EVX_ERROR_INVALIDARG;
+    }
+
+    const char *name = strrchr(path, '/');
+    snprintf(input->name, sizeof(input->name), "file:%s", name ? name + 1 : path);
+
+    /* Keep the name a plain JSON string. */
+    for (char *c = input->name; *c; ++c)
+    {
+        if ('"' == *c || '\\' == *c || (uint8) *c < 0x20)
+        {
+            *c = '_';
+        }
+    }
+
+    if ((size_t) size != fread(input->bits.data_store, 1, (size_t) size, file))
+    {
+        fclose(file);
+        fprintf(stderr, "cabac_bench: cannot read %s\n", path);
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    fclose(file);
+    input->bits.write_index = (uint64) size << 3;
+    input->entropy = cabac_bench_order0_entropy(&input->bits);
+
+    return EVX_SUCCESS;
+}
+
+static void cabac_bench_create_inputs(cabac_bench_input_t *inputs, uint32 *count, uint64 byte_count)
+{
+    cabac_bench_input_t *input = 0;
+
+    for (uint32 i = 0; i < sizeof(cabac_bench_bernoulli) / sizeof(cabac_bench_bernoulli[0]); ++i)
+    {
+        input = cabac_bench_add_input(inputs, count, "bernoulli", byte_count);
+        snprintf(input->name, sizeof(input->name), "bernoulli_p%g", cabac_bench_bernoulli[i]);
+        cabac_bench_fill_bits(&input->bits, byte_count, cabac_bench_bernoulli[i], 0.0);
+        input->entropy = cabac_bench_binary_entropy(cabac_bench_bernoulli[i]);
+    }
+
+    for (uint32 i = 0; i < sizeof(cabac_bench_markov) / sizeof(cabac_bench_markov[0]); ++i)
+    {
+        input = cabac_bench_add_input(inputs, count, "markov", byte_count);
+        snprintf(input->name, sizeof(input->name), "markov_s%g", cabac_bench_markov[i]);
+        cabac_bench_fill_bits(&input->bits, byte_count, 0.0, cabac_bench_markov[i]);
+        input->entropy = cabac_bench_binary_entropy(1.0 - cabac_bench_markov[i]);
+    }
+
+    input = cabac_bench_add_input(inputs, count, "bernoulli", byte_count);
+    snprintf(input->name, sizeof(input->name), "zeros");
+    memset(input->bits.data_store, 0, (size_t) byte_count);
+    input->bits.write_index = byte_count << 3;
+
+    input = cabac_bench_add_input(inputs, count, "bernoulli", byte_count);
+    snprintf(input->name, sizeof(input->name), "random");
+    cabac_bench_fill_bits(&input->bits, byte_count, 0.5, 0.0);
+    input->entropy = 1.0;
+
+    input = cabac_bench_add_input(inputs, count, "order0", byte_count);
+    snprintf(input->name, sizeof(input->name), "text");
+    cabac_bench_fill_text(input, byte_count);
+    input->entropy = cabac_bench_order0_entropy(&input->bits);
+}
+
+static void cabac_bench_configure(entropy_coder_t *coder, const cabac_bench_config_t *config)
+{
+    if (EVX_ENTROPY_MODEL_COUNT == config->model)
+    {
+        entropy_coder_init1(coder);
+    }
+    else
+    {
+        entropy_coder_init3(coder, config->rate);
+    }
+
+    entropy_coder_select_engine(coder, config->engine);
+}
+
+static uint8 cabac_bench_compare(const bitstream_t *a, const bitstream_t *b)
+{
+    uint64 count = a->write_index;
+
+    if (count != b->write_index)
+    {
+        return 0;
+    }
+
+    if (memcmp(a->data_store, b->data_store, (size_t) (count >> 3)))
+    {
+        return 0;
+    }
+
+    uint8 mask = (uint8) ((0x1 << (count & 7)) - 1);
+
+    return !mask || 0 == ((a->data_store[count >> 3] ^ b->data_store[count >> 3]) & mask);
+}
+
+static void cabac_bench_print_separator(uint8 *first)
+{
+    printf("%s\n", *first ? "" : ",");
+    *first = 0;
+}
+
+static evx_status cabac_bench_run_throughput(const cabac_bench_config_t *config, cabac_bench_input_t *input, uint8 *first)
+{
+    uint64 bin_count = input->bits.write_index;
+    double encode_seconds = 0.0;
+    double decode_seconds = 0.0;
+    entropy_coder_t coder;
+    bitstream_t coded;
+    bitstream_t decoded;
+
+    cabac_bench_configure(&coder, config);
+    bitstream_create_new(&coded, (entropy_coder_query_encode_bound(&coder, bin_count) + 8) << 3);
+    bitstream_create_new(&decoded, bin_count + 64);
+
+    for (uint32 i = 0; i < config->iterations; ++i)
+    {
+        cabac_bench_configure(&coder, config);
+        bitstream_empty(&coded);
+        input->bits.read_index = 0;
+
+        double start = cabac_bench_query_time();
+
+        if (EVX_SUCCESS != entropy_coder_encode(&coder, &input->bits, &coded))
+        {
+            bitstream_clear(&coded);
+            bitstream_clear(&decoded);
+            return EVX_ERROR_EXECUTION_FAILURE;
+        }
+
+        double seconds = cabac_bench_query_time() - start;
+        encode_seconds = (0 == i) ? seconds : evx_min2(encode_seconds, seconds);
+    }
+
+    for (uint32 i = 0; i < config->iterations; ++i)
+    {
+        cabac_bench_configure(&coder, config);
+        bitstream_empty(&decoded);
+        coded.read_index = 0;
+
+        double start = cabac_bench_query_time();
+
+        if (EVX_SUCCESS != entropy_coder_decode(&coder, bin_count, &coded, &decoded))
+        {
+            bitstream_clear(&coded);
+            bitstream_clear(&decoded);
+            return EVX_ERROR_EXECUTION_FAILURE;
+        }
+
+        double seconds = cabac_bench_query_time() - start;
+        decode_seconds = (0 == i) ? seconds : evx_min2(decode_seconds, seconds);
+    }
+
+    uint64 coded_bytes = (coded.write_index + 7) >> 3;
+    uint8 verified = cabac_bench_compare(&input->bits, &decoded);
+    double megabytes = (double) (bin_count >> 3) / (1024.0 * 1024.0);
+    double bits_per_bin = (double) (coded_bytes << 3) / (double) bin_count;
+
+    cabac_bench_print_separator(first);
+    printf("    {\"input\": \"%s\", \"kind\": \"%s\", \"engine\": \"%s\", \"model\": \"%s\", \"rate\": %u, "
+           "\"bins\": %llu, \"coded_bytes\": %llu, \"bits_per_bin\": %.6f, \"entropy\": %.6f, "
+           "\"redundancy\": %.6f, \"encode_mb_per_s\": %.2f, \"decode_mb_per_s\": %.2f, "
+           "\"encode_ns_per_bin\": %.3f, \"decode_ns_per_bin\": %.3f, \"verified\": %s}",
+           input->name, input->kind, cabac_bench_engine_names[config->engine],
+           cabac_bench_model_names[config->model], config->rate, (unsigned long long) bin_count,
+           (unsigned long long) coded_bytes, bits_per_bin, input->entropy, bits_per_bin - input->entropy,
+           megabytes / encode_seconds, megabytes / decode_seconds,
+           encode_seconds * 1e9 / (double) bin_count, decode_seconds * 1e9 / (double) bin_count,
+           verified ? "true" : "false");
+
+    fprintf(stderr, "%-18s %-10s %8.2f MB/s encode %8.2f MB/s decode %.4f bits/bin (entropy %.4f)\n",
+            input->name, cabac_bench_engine_names[config->engine], megabytes / encode_seconds,
+            megabytes / decode_seconds, bits_per_bin, input->entropy);
+
+    bitstream_clear(&coded);
+    bitstream_clear(&decoded);
+
+    return verified ? EVX_SUCCESS : EVX_ERROR_INVALID_RESOURCE;
+}
+
+static int cabac_bench_compare_times(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+
+    return (x > y) - (x < y);
+}
+
+static double cabac_bench_percentile(const double *sorted, uint32 count, double fraction)
+{
+    uint32 index = (uint32) (fraction * (double) (count - 1) + 0.5);
+
+    return sorted[evx_min2(index, count - 1)] * 1e9;
+}
+
+static evx_status cabac_bench_run_latency(const cabac_bench_config_t *config, uint32 message_bytes, uint8 *first)
+{
+    const uint32 message_count = EVX_BENCH_MESSAGE_COUNT;
+    const uint64 bin_count = (uint64) message_bytes << 3;
+    double *encode_times = (double *) malloc(message_count * sizeof(double));
+    double *decode_times = (double *) malloc(message_count * sizeof(double));
+    evx_status result = EVX_SUCCESS;
+    entropy_coder_t coder;
+    bitstream_t message;
+    bitstream_t coded;
+    bitstream_t decoded;
+
+    cabac_bench_configure(&coder, config);
+    bitstream_create_new(&message, bin_count);
+    bitstream_create_new(&coded, (entropy_coder_query_encode_bound(&coder, bin_count) + 8) << 3);
+    bitstream_create_new(&decoded, bin_count + 64);
+
+    for (uint32 i = 0; i < message_count && EVX_SUCCESS == result; ++i)
+    {
+        /* Each message is a fresh record drawn from a skewed source. */
+        bitstream_empty(&message);
+        cabac_bench_fill_bits(&message, message_bytes, 0.1, 0.0);
+        bitstream_empty(&coded);
+        bitstream_empty(&decoded);
+
+        double start = cabac_bench_query_time();
+        cabac_bench_configure(&coder, config);
+        result = entropy_coder_encode(&coder, &message, &coded);
+        double middle = cabac_bench_query_time();
+
+        cabac_bench_configure(&coder, config);
+
+        if (EVX_SUCCESS == result)
+        {
+            result = entropy_coder_decode(&coder, bin_count, &coded, &decoded);
+        }
+
+        double end = cabac_bench_query_time();
+        message.read_index = 0;
+
+        if (EVX_SUCCESS == result && !cabac_bench_compare(&message, &decoded))
+        {
+            result = EVX_ERROR_INVALID_RESOURCE;
+        }
+
+        encode_times[i] = middle - start;
+        decode_times[i] = end - middle;
+    }
+
+    if (EVX_SUCCESS == result)
+    {
+        qsort(encode_times, message_count, sizeof(double), cabac_bench_compare_times);
+        qsort(decode_times, message_count, sizeof(double), cabac_bench_compare_times);
+
+        cabac_bench_print_separator(first);
+        printf("    {\"engine\": \"%s\", \"model\": \"%s\", \"rate\": %u, \"message_bytes\": %u, \"messages\": %u, "
+               "\"encode_ns\": {\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"p999\": %.0f, \"max\": %.0f}, "
+               "\"decode_ns\": {\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"p999\": %.0f, \"max\": %.0f}}",
+               cabac_bench_engine_names[config->engine], cabac_bench_model_names[config->model], config->rate,
+               message_bytes, message_count,
+               cabac_bench_percentile(encode_times, message_count, 0.5),
+               cabac_bench_percentile(encode_times, message_count, 0.9),
+               cabac_bench_percentile(encode_times, message_count, 0.99),
+               cabac_bench_percentile(encode_times, message_count, 0.999),
+               encode_times[message_count - 1] * 1e9,
+               cabac_bench_percentile(decode_times, message_count, 0.5),
+               cabac_bench_percentile(decode_times, message_count, 0.9),
+               cabac_bench_percentile(decode_times, message_count, 0.99),
+               cabac_bench_percentile(decode_times, message_count, 0.999),
+               decode_times[message_count - 1] * 1e9);
+    }
+
+    free(encode_times);
+    free(decode_times);
+    bitstream_clear(&message);
+    bitstream_clear(&coded);
+    bitstream_clear(&decoded);
+
+    return result;
+}
+
+static void cabac_bench_usage()
+{
+    fprintf(stderr, "usage: cabac_bench [-e arithmetic|range|rans] [-m shift|count] [-r rate] "
+                    "[-n bytes] [-i iterations] [file ...]\n");
+}
+
+int main(int argc, char **argv)
+{
+    cabac_bench_config_t config = {0, EVX_ENTROPY_MODEL_SHIFT, EVX_ENTROPY_RATE_DEFAULT, EVX_BENCH_ITERATIONS_DEFAULT};
+    cabac_bench_input_t inputs[EVX_BENCH_INPUTS_MAX];
+    uint64 byte_count = EVX_BENCH_BYTES_DEFAULT;
+    uint8 engine_first = EVX_ENTROPY_ENGINE_ARITHMETIC;
+    uint8 engine_last = EVX_ENTROPY_ENGINE_RANS;
+    uint32 input_count = 0;
+    evx_status result = EVX_SUCCESS;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-e") && i + 1 < argc)
+        {
+            const char *engine = argv[++i];
+            engine_first = !strcmp(engine, "arithmetic") ? EVX_ENTROPY_ENGINE_ARITHMETIC :
+                           !strcmp(engine, "range") ? EVX_ENTROPY_ENGINE_RANGE :
+                           !strcmp(engine, "rans") ? EVX_ENTROPY_ENGINE_RANS : 0xFF;
+            engine_last = engine_first;
+        }
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+        {
+            const char *model = argv[++i];
+            config.model = !strcmp(model, "count") ? EVX_ENTROPY_MODEL_COUNT :
+                           !strcmp(model, "shift") ? EVX_ENTROPY_MODEL_SHIFT : 0xFF;
+        }
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+        {
+            config.rate = (uint8) atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+        {
+            byte_count = (uint64) strtoull(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+        {
+            config.iterations = (uint32) atoi(argv[++i]);
+        }
+        else if ('-' == argv[i][0])
+        {
+            cabac_bench_usage();
+            return 2;
+        }
+    }
+
+    if (engine_first > EVX_ENTROPY_ENGINE_RANS || 0xFF == config.model || 0 == byte_count || 0 == config.iterations ||
+        config.rate < EVX_ENTROPY_RATE_MIN || config.rate > EVX_ENTROPY_RATE_MAX)
+    {
+        cabac_bench_usage();
+        return 2;
+    }
+
+    cabac_bench_create_inputs(inputs, &input_count, byte_count);
+
+    for (int i = 1; i < argc && EVX_SUCCESS == result; ++i)
+    {
+        if ('-' == argv[i][0])
+        {
+            ++i;
+            continue;
+        }
+
+        result = cabac_bench_load_file(inputs, &input_count, argv[i]);
+    }
+
+    printf("{\n  \"schema\": %u,\n  \"probability_bits\": %u,\n  \"iterations\": %u,\n  \"throughput\": [",
+           EVX_BENCH_SCHEMA, EVX_ENTROPY_PROBABILITY_BITS, config.iterations);
+
+    uint8 first = 1;
+
+    for (uint8 engine = engine_first; engine <= engine_last && EVX_SUCCESS == result; ++engine)
+    {
+        config.engine = engine;
+
+        for (uint32 i = 0; i < input_count && EVX_SUCCESS == result; ++i)
+        {
+            result = cabac_bench_run_throughput(&config, &inputs[i], &first);
+        }
+    }
+
+    printf("\n  ],\n  \"latency\": [");
+    first = 1;
+
+    for (uint8 engine = engine_first; engine <= engine_last && EVX_SUCCESS == result; ++engine)
+    {
+        config.engine = engine;
+
+        for (uint32 i = 0; i < sizeof(cabac_bench_message_bytes) / sizeof(cabac_bench_message_bytes[0]) &&
+                           EVX_SUCCESS == result; ++i)
+        {
+            result = cabac_bench_run_latency(&config, cabac_bench_message_bytes[i], &first);
+        }
+    }
+
+    printf("\n  ]\n}\n");
+
+    for (uint32 i = 0; i < input_count; ++i)
+    {
+        bitstream_clear(&inputs[i].bits);
+    }
+
+    if (EVX_SUCCESS != result)
+    {
+        fprintf(stderr, "cabac_bench: failed with error %d\n", result);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,714 @@
+
+#include "stream_cabac.h"
+
+#if defined (EVX_PLATFORM_WINDOWS)
+    #error "cabac_tool requires a POSIX platform (mmap and pwrite)."
+#endif
+
+#include "errno.h"
+#include "fcntl.h"
+#include "time.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+
+/*
+// cabac_tool
+//
+// Compresses and decompresses files with the entropy coder:
+//
+//   cabac_tool c [-e arithmetic|range] [-m shift|count] [-r rate] [input [output]]
+//   cabac_tool d [input [output]]
+//
+// A missing path or "-" selects stdin or stdout. A regular input file is
+// memory mapped and coded in place. When the output is a regular file too,
+// it is sized up front and mapped, so neither side is copied through a read
+// or write loop. Pipes fall back to the streaming encoder and decoder in
+// stream_cabac.h, which hold a constant amount of memory.
+//
+// A compressed file is a 16 byte header followed by a terminated codeword
+// (see entropy_coder_encode_terminated):
+//
+//   uint32   magic (EVX_TOOL_MAGIC)
+//   uint8    version
+//   uint8    engine
+//   uint8    model (EVX_ENTROPY_MODEL_COUNT or EVX_ENTROPY_MODEL_SHIFT)
+//   uint8    rate
+//   uint64   uncompressed size in bytes, or EVX_MAX_UINT64 if it was unknown
+//
+// All fields are little endian. Throughput and ratio are reported on stderr.
+*/
+
+#define EVX_TOOL_MAGIC                  (0x46585645)      // 'EVXF'
+#define EVX_TOOL_VERSION                (1)
+#define EVX_TOOL_HEADER_BYTES           (16)
+#define EVX_TOOL_SIZE_UNKNOWN           (EVX_MAX_UINT64)
+#define EVX_TOOL_BLOCK_BYTES            (((uint32) 0x1 << EVX_ENTROPY_TERMINATE_BLOCK_BITS) >> 3)
+#define EVX_TOOL_FRAGMENT_BYTES         (64 * EVX_KB)
+#define EVX_TOOL_DECODED_BYTES          (1 * EVX_MB)
+
+typedef struct
+{
+    uint8 engine;
+    uint8 model;
+    uint8 rate;
+    uint64 size;
+} cabac_tool_header_t;
+
+typedef struct
+{
+    int fd;
+    const uint8 *map;
+    uint64 size;
+    uint8 mapped;
+} cabac_tool_input_t;
+
+typedef struct
+{
+    int fd;
+    uint64 offset;
+    uint8 seekable;
+    uint8 mappable;
+} cabac_tool_output_t;
+
+static double cabac_tool_query_time()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+static void cabac_tool_usage()
+{
+    fprintf(stderr, "usage: cabac_tool c [-e arithmetic|range] [-m shift|count] [-r rate] [input [output]]\n");
+    fprintf(stderr, "       cabac_tool d [input [output]]\n");
+}
+
+static void cabac_tool_store_header(uint8 *dest, const cabac_tool_header_t *header)
+{
+    uint32 magic = EVX_TOOL_MAGIC;
+
+    for (uint8 i = 0; i < 4; ++i)
+    {
+        dest[i] = (uint8) (magic >> (i << 3));
+    }
+
+    dest[4] = EVX_TOOL_VERSION;
+    dest[5] = header->engine;
+    dest[6] = header->model;
+    dest[7] = header->rate;
+
+    for (uint8 i = 0; i < 8; ++i)
+    {
+        dest[8 + i] = (uint8) (header->size >> (i << 3));
+    }
+}
+
+static evx_status cabac_tool_load_header(const uint8 *source, cabac_tool_header_t *header)
+{
+    uint32 magic = 0;
+
+    for (uint8 i = 0; i < 4; ++i)
+    {
+        magic |= (uint32) source[i] << (i << 3);
+    }
+
+    if (EVX_TOOL_MAGIC != magic || EVX_TOOL_VERSION != source[4])
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    header->engine = source[5];
+    header->model = source[6];
+    header->rate = source[7];
+    header->size = 0;
+
+    for (uint8 i = 0; i < 8; ++i)
+    {
+        header->size |= (uint64) source[8 + i] << (i << 3);
+    }
+
+    if (header->engine > EVX_ENTROPY_ENGINE_RANGE ||
+        (EVX_ENTROPY_MODEL_COUNT != header->model && EVX_ENTROPY_MODEL_SHIFT != header->model) ||
+        header->rate < EVX_ENTROPY_RATE_MIN || header->rate > EVX_ENTROPY_RATE_MAX)
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    return EVX_SUCCESS;
+}
+
+static evx_status cabac_tool_configure(entropy_coder_t *coder, const cabac_tool_header_t *header)
+{
+    if (EVX_ENTROPY_MODEL_COUNT == header->model)
+    {
+        entropy_coder_init1(coder);
+    }
+    else
+    {
+        entropy_coder_init3(coder, header->rate);
+    }
+
+    return entropy_coder_select_engine(coder, header->engine);
+}
+
+static evx_status cabac_tool_open_input(const char *path, cabac_tool_input_t *input)
+{
+    struct stat info;
+
+    input->fd = STDIN_FILENO;
+    input->map = 0;
+    input->size = 0;
+    input->mapped = 0;
+
+    if (path && strcmp(path, "-"))
+    {
+        input->fd = open(path, O_RDONLY);
+
+        if (input->fd < 0)
+        {
+            fprintf(stderr, "cabac_tool: cannot open %s: %s\n", path, strerror(errno));
+            return EVX_ERROR_IO_FAILURE;
+        }
+    }
+
+    if (0 == fstat(input->fd, &info) && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *map = mmap(0, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, input->fd, 0);
+
+        if (MAP_FAILED != map)
+        {
+            madvise(map, (size_t) info.st_size, MADV_SEQUENTIAL);
+            input->map = (const uint8 *) map;
+            input->size = (uint64) info.st_size;
+            input->mapped = 1;
+        }
+    }
+
+    return EVX_SUCCESS;
+}
+
+static void cabac_tool_close_input(cabac_tool_input_t *input)
+{
+    if (input->mapped)
+    {
+        munmap((void *) input->map, (size_t) input->size);
+    }
+
+    if (STDIN_FILENO != input->fd)
+    {
+        close(input->fd);
+    }
+}
+
+static evx_status cabac_tool_open_output(const char *path, cabac_tool_output_t *output)
+{
+    struct stat info;
+
+    output->fd = STDOUT_FILENO;
+    output->offset = 0;
+    output->seekable = 0;
+    output->mappable = 0;
+
+    if (path && strcmp(path, "-"))
+    {
+        output->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (output->fd < 0)
+        {
+            fprintf(stderr, "cabac_tool: cannot create %s: %s\n", path, strerror(errno));
+            return EVX_ERROR_IO_FAILURE;
+        }
+    }
+
+    /* stdout is always appended to, even when it is redirected to a file, since
+       it may not start at offset zero. */
+    output->seekable = (STDOUT_FILENO != output->fd && 0 == fstat(output->fd, &info) && S_ISREG(info.st_mode));
+    output->mappable = output->seekable;
+
+    return EVX_SUCCESS;
+}
+
+static void cabac_tool_close_output(cabac_tool_output_t *output)
+{
+    if (STDOUT_FILENO != output->fd)
+    {
+        close(output->fd);
+    }
+}
+
+/* Reads until count bytes arrive or the input ends, and returns the number read. */
+static int64 cabac_tool_read(int fd, uint8 *dest, uint64 count)
+{
+    uint64 total = 0;
+
+    while (total < count)
+    {
+        ssize_t result = read(fd, dest + total, (size_t) (count - total));
+
+        if (result < 0 && EINTR == errno)
+        {
+            continue;
+        }
+
+        if (result < 0)
+        {
+            return -1;
+        }
+
+        if (0 == result)
+        {
+            break;
+        }
+
+        total += (uint64) result;
+    }
+
+    return (int64) total;
+}
+
+/* A bitstream sink that appends to the output with pwrite, or write for pipes. */
+static evx_status cabac_tool_sink(void *param, const uint8 *data, uint64 byte_count)
+{
+    cabac_tool_output_t *output = (cabac_tool_output_t *) param;
+
+    while (byte_count)
+    {
+        ssize_t result = output->seekable ? pwrite(output->fd, data, (size_t) byte_count, (off_t) output->offset) :
+                                            write(output->fd, data, (size_t) byte_count);
+
+        if (result < 0 && EINTR == errno)
+        {
+            continue;
+        }
+
+        if (result <= 0)
+        {
+            return EVX_ERROR_IO_FAILURE;
+        }
+
+        data += result;
+        byte_count -= (uint64) result;
+        output->offset += (uint64) result;
+    }
+
+    return EVX_SUCCESS;
+}
+
+/* Codes one block of the terminated format into the active session. */
+static evx_status cabac_tool_encode_block(entropy_coder_t *coder, const uint8 *block, uint32 byte_count)
+{
+    uint8 last = (byte_count < EVX_TOOL_BLOCK_BYTES);
+
+    if (EVX_SUCCESS != entropy_coder_encode_terminate(coder, last) ||
+        (last && EVX_SUCCESS != entropy_coder_encode_bypass(coder, byte_count << 3, EVX_ENTROPY_TERMINATE_BLOCK_BITS)))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    for (uint32 i = 0; i < byte_count; i += 4)
+    {
+        uint32 count = evx_min2(byte_count - i, 4);
+        uint32 bits = 0;
+
+        for (uint32 j = 0; j < count; ++j)
+        {
+            bits |= (uint32) block[i + j] << (j << 3);
+        }
+
+        if (EVX_SUCCESS != entropy_coder_encode_bits(coder, bits, (uint8) (count << 3)))
+        {
+            return EVX_ERROR_IO_FAILURE;
+        }
+    }
+
+    return EVX_SUCCESS;
+}
+
+static evx_status cabac_tool_compress_mapped(entropy_coder_t *coder, cabac_tool_header_t *header,
+                                             cabac_tool_input_t *input, cabac_tool_output_t *output)
+{
+    /* Size the output for the worst case, map it, and code straight into it. */
+    uint64 bound = EVX_TOOL_HEADER_BYTES + entropy_coder_query_encode_bound(coder, input->size << 3) +
+                   (input->size / EVX_TOOL_BLOCK_BYTES + 2) * 2;
+
+    if (0 != ftruncate(output->fd, (off_t) bound))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    void *map = mmap(0, (size_t) bound, PROT_READ | PROT_WRITE, MAP_SHARED, output->fd, 0);
+
+    if (MAP_FAILED == map)
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    bitstream_t source;
+    bitstream_t dest;
+    bitstream_create_view(&source, input->map, input->size);
+    bitstream_create_refer(&dest, (uint8 *) map + EVX_TOOL_HEADER_BYTES, bound - EVX_TOOL_HEADER_BYTES, 0);
+
+    header->size = input->size;
+    cabac_tool_store_header((uint8 *) map, header);
+
+    evx_status result = entropy_coder_encode_terminated(coder, &source, &dest);
+    output->offset = EVX_TOOL_HEADER_BYTES + bitstream_query_byte_occupancy(&dest);
+
+    bitstream_clear(&source);
+    bitstream_clear(&dest);
+    munmap(map, (size_t) bound);
+
+    if (EVX_SUCCESS != result || 0 != ftruncate(output->fd, (off_t) output->offset))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    return EVX_SUCCESS;
+}
+
+static evx_status cabac_tool_compress_stream(entropy_coder_t *coder, cabac_tool_header_t *header,
+                                             cabac_tool_input_t *input, cabac_tool_output_t *output)
+{
+    uint8 prefix[EVX_TOOL_HEADER_BYTES];
+    uint8 block[EVX_TOOL_BLOCK_BYTES];
+    entropy_stream_encoder_t stream;
+    evx_status result = EVX_SUCCESS;
+    uint64 consumed = 0;
+    int64 count = 0;
+
+    header->size = input->mapped ? input->size : EVX_TOOL_SIZE_UNKNOWN;
+    cabac_tool_store_header(prefix, header);
+
+    if (EVX_SUCCESS != cabac_tool_sink(output, prefix, EVX_TOOL_HEADER_BYTES) ||
+        EVX_SUCCESS != entropy_stream_start_encode(&stream, coder, cabac_tool_sink, output, 0))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    do
+    {
+        const uint8 *data = block;
+
+        if (input->mapped)
+        {
+            count = (int64) evx_min2(input->size - consumed, EVX_TOOL_BLOCK_BYTES);
+            data = input->map + consumed;
+        }
+        else
+        {
+            count = cabac_tool_read(input->fd, block, EVX_TOOL_BLOCK_BYTES);
+        }
+
+        if (count < 0)
+        {
+            result = EVX_ERROR_IO_FAILURE;
+            break;
+        }
+
+        consumed += (uint64) count;
+        result = cabac_tool_encode_block(coder, data, (uint32) count);
+
+    } while (EVX_SUCCESS == result && EVX_TOOL_BLOCK_BYTES == count);
+
+    if (EVX_SUCCESS != entropy_stream_finish_encode(&stream) || EVX_SUCCESS != result)
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    /* Once the size is known, patch it into the header if the output allows. */
+    if (!input->mapped && output->seekable)
+    {
+        header->size = consumed;
+        cabac_tool_store_header(prefix, header);
+
+        if (EVX_TOOL_HEADER_BYTES != pwrite(output->fd, prefix, EVX_TOOL_HEADER_BYTES, 0))
+        {
+            return EVX_ERROR_IO_FAILURE;
+        }
+    }
+
+    input->size = consumed;
+
+    return EVX_SUCCESS;
+}
+
+static evx_status cabac_tool_decompress_mapped(entropy_coder_t *coder, const cabac_tool_header_t *header,
+                                               cabac_tool_input_t *input, cabac_tool_output_t *output)
+{
+    if (0 != ftruncate(output->fd, (off_t) header->size))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    void *map = mmap(0, (size_t) header->size, PROT_READ | PROT_WRITE, MAP_SHARED, output->fd, 0);
+
+    if (MAP_FAILED == map)
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    bitstream_t source;
+    bitstream_t dest;
+    bitstream_create_view(&source, input->map + EVX_TOOL_HEADER_BYTES, input->size - EVX_TOOL_HEADER_BYTES);
+    bitstream_create_refer(&dest, (uint8 *) map, header->size, 0);
+
+    evx_status result = entropy_coder_decode_terminated(coder, &source, &dest);
+    output->offset = bitstream_query_byte_occupancy(&dest);
+
+    bitstream_clear(&source);
+    bitstream_clear(&dest);
+    munmap(map, (size_t) header->size);
+
+    if (EVX_SUCCESS != result || output->offset != header->size)
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    return EVX_SUCCESS;
+}
+
+/* Hands every whole decoded byte to the output and keeps any partial byte. */
+static evx_status cabac_tool_drain(bitstream_t *decoded, cabac_tool_output_t *output)
+{
+    uint64 byte_count = decoded->write_index >> 3;
+    uint8 partial_bits = decoded->write_index % 8;
+
+    if (byte_count && EVX_SUCCESS != cabac_tool_sink(output, decoded->data_store, byte_count))
+    {
+        return EVX_ERROR_IO_FAILURE;
+    }
+
+    if (partial_bits)
+    {
+        decoded->data_store[0] = decoded->data_store[byte_count];
+    }
+
+    decoded->write_index = partial_bits;
+    decoded->read_index = 0;
+
+    return EVX_SUCCESS;
+}
+
+static evx_status cabac_tool_decompress_stream(entropy_coder_t *coder, cabac_tool_input_t *input, cabac_tool_output_t *output)
+{
+    uint8 *fragment = (uint8 *) malloc(EVX_TOOL_FRAGMENT_BYTES);
+    entropy_stream_decoder_t stream;
+    bitstream_t decoded;
+    evx_status result = EVX_ERROR_NEED_MORE_INPUT;
+    uint64 consumed = EVX_TOOL_HEADER_BYTES;
+
+    /* A fixed output buffer keeps memory constant however well the data compressed. */
+    bitstream_create_init(&decoded);
+    bitstream_resize_capacity(&decoded, (uint64) EVX_TOOL_DECODED_BYTES << 3);
+
+    if (!fragment || !decoded.data_store || EVX_SUCCESS != entropy_stream_start_decode(&stream, coder, 0))
+    {
+        bitstream_clear(&decoded);
+        free(fragment);
+        return EVX_ERROR_OUTOFMEMORY;
+    }
+
+    while (EVX_ERROR_NEED_MORE_INPUT == result || EVX_ERROR_CAPACITY_LIMIT == result)
+    {
+        /* A full output buffer is simply drained and decoding continues. */
+        if (EVX_ERROR_NEED_MORE_INPUT == result)
+        {
+            int64 count = input->mapped ? (int64) evx_min2(input->size - consumed, EVX_TOOL_FRAGMENT_BYTES) :
+                                          cabac_tool_read(input->fd, fragment, EVX_TOOL_FRAGMENT_BYTES);
+
+            if (count < 0)
+            {
+                result = EVX_ERROR_IO_FAILURE;
+                break;
+            }
+
+            if (count)
+            {
+                entropy_stream_push(&stream, input->mapped ? input->map + consumed : fragment, (uint64) count);
+            }
+            else
+            {
+                entropy_stream_end_input(&stream);
+            }
+
+            consumed += (uint64) count;
+        }
+
+        result = entropy_stream_decode(&stream, &decoded);
+
+        if ((EVX_SUCCESS == result || EVX_ERROR_NEED_MORE_INPUT == result || EVX_ERROR_CAPACITY_LIMIT == result) &&
+            EVX_SUCCESS != cabac_tool_drain(&decoded, output))
+        {
+            result = EVX_ERROR_IO_FAILURE;
+        }
+
+        if (stream.input_ended && EVX_ERROR_NEED_MORE_INPUT == result)
+        {
+            result = EVX_ERROR_INVALID_RESOURCE;
+        }
+    }
+
+    input->size = consumed;
+    entropy_stream_finish_decode(&stream);
+    bitstream_clear(&decoded);
+    free(fragment);
+
+    return result;
+}
+
+/* Prints input -> output in the direction of the operation. The ratio and 
+   throughput are always measured against the uncompressed size. */
+static void cabac_tool_report(const char *operation, uint64 input_bytes, uint64 output_bytes, uint8 compress, double seconds)
+{
+    uint64 raw_bytes = compress ? input_bytes : output_bytes;
+    uint64 coded_bytes = compress ? output_bytes : input_bytes;
+    double ratio = raw_bytes ? (double) coded_bytes / (double) raw_bytes : 0.0;
+    double rate = seconds > 0.0 ? (double) raw_bytes / (1024.0 * 1024.0) / seconds : 0.0;
+
+    fprintf(stderr, "%s: %llu -> %llu bytes, ratio %.4f (%.3f bits per byte), %.3f s, %.1f MB/s\n",
+            operation, (unsigned long long) input_bytes, (unsigned long long) output_bytes,
+            ratio, ratio * 8.0, seconds, rate);
+}
+
+int main(int argc, char **argv)
+{
+    cabac_tool_header_t header = {EVX_ENTROPY_ENGINE_RANGE, EVX_ENTROPY_MODEL_SHIFT, EVX_ENTROPY_RATE_DEFAULT, 0};
+    const char *paths[2] = {0, 0};
+    uint32 path_count = 0;
+    uint8 compress = 0;
+
+    if (argc < 2 || (strcmp(argv[1], "c") && strcmp(argv[1], "d")))
+    {
+        cabac_tool_usage();
+        return 2;
+    }
+
+    compress = ('c' == argv[1][0]);
+
+    for (int i = 2; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-e") && i + 1 < argc)
+        {
+            const char *engine = argv[++i];
+            header.engine = !strcmp(engine, "arithmetic") ? EVX_ENTROPY_ENGINE_ARITHMETIC :
+                            !strcmp(engine, "range") ? EVX_ENTROPY_ENGINE_RANGE : 0xFF;
+        }
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+        {
+            const char *model = argv[++i];
+            header.model = !strcmp(model, "count") ? EVX_ENTROPY_MODEL_COUNT :
+                           !strcmp(model, "shift") ? EVX_ENTROPY_MODEL_SHIFT : 0xFF;
+        }
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+        {
+            header.rate = (uint8) atoi(argv[++i]);
+        }
+        else if (path_count < 2 && (strcmp(argv[i], "-") == 0 || '-' != argv[i][0]))
+        {
+            paths[path_count++] = argv[i];
+        }
+        else
+        {
+            cabac_tool_usage();
+            return 2;
+        }
+    }
+
+    if (header.engine > EVX_ENTROPY_ENGINE_RANGE || 0xFF == header.model ||
+        header.rate < EVX_ENTROPY_RATE_MIN || header.rate > EVX_ENTROPY_RATE_MAX)
+    {
+        cabac_tool_usage();
+        return 2;
+    }
+
+    cabac_tool_input_t input;
+    cabac_tool_output_t output;
+    entropy_coder_t coder;
+    evx_status result = EVX_SUCCESS;
+
+    if (EVX_SUCCESS != cabac_tool_open_input(paths[0], &input))
+    {
+        return 1;
+    }
+
+    if (EVX_SUCCESS != cabac_tool_open_output(paths[1], &output))
+    {
+        cabac_tool_close_input(&input);
+        return 1;
+    }
+
+    double start = cabac_tool_query_time();
+
+    if (compress)
+    {
+        cabac_tool_configure(&coder, &header);
+
+        if (input.mapped && output.mappable)
+        {
+            result = cabac_tool_compress_mapped(&coder, &header, &input, &output);
+        }
+        else
+        {
+            result = cabac_tool_compress_stream(&coder, &header, &input, &output);
+        }
+
+        if (EVX_SUCCESS == result)
+        {
+            cabac_tool_report("compressed", input.size, output.offset, compress, cabac_tool_query_time() - start);
+        }
+    }
+    else
+    {
+        uint8 prefix[EVX_TOOL_HEADER_BYTES];
+        const uint8 *source = input.map;
+
+        if (!input.mapped)
+        {
+            source = prefix;
+
+            if (EVX_TOOL_HEADER_BYTES != cabac_tool_read(input.fd, prefix, EVX_TOOL_HEADER_BYTES))
+            {
+                result = EVX_ERROR_INVALID_RESOURCE;
+            }
+        }
+        else if (input.size < EVX_TOOL_HEADER_BYTES)
+        {
+            result = EVX_ERROR_INVALID_RESOURCE;
+        }
+
+        if (EVX_SUCCESS == result)
+        {
+            result = cabac_tool_load_header(source, &header);
+        }
+
+        if (EVX_SUCCESS == result)
+        {
+            cabac_tool_configure(&coder, &header);
+
+            if (input.mapped && output.mappable && header.size && EVX_TOOL_SIZE_UNKNOWN != header.size)
+            {
+                result = cabac_tool_decompress_mapped(&coder, &header, &input, &output);
+            }
+            else
+            {
+                result = cabac_tool_decompress_stream(&coder, &input, &output);
+            }
+        }
+
+        if (EVX_SUCCESS == result)
+        {
+            cabac_tool_report("decompressed", input.size, output.offset, compress, cabac_tool_query_time() - start);
+        }
+    }
+
+    if (EVX_SUCCESS != result)
+    {
+        fprintf(stderr, "cabac_tool: %s failed (error %u)\n", compress ? "compression" : "decompression", result);
+    }
+
+    cabac_tool_close_output(&output);
+    cabac_tool_close_input(&input);
+
+    return (EVX_SUCCESS == result) ? 0 : 1;
+}
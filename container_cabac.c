@@ -0,0 +1,559 @@
+
+#include "container_cabac.h"
+
+#if defined (_M_X64) || defined (__x86_64__)
+    #define EVX_CONTAINER_X64
+    #include "nmmintrin.h"
+
+    #if defined (EVX_PLATFORM_WINDOWS)
+        #include "intrin.h"
+        #define EVX_TARGET_SSE42
+    #else
+        #define EVX_TARGET_SSE42            __attribute__((target("sse4.2")))
+    #endif
+#endif
+
+/* The reflected CRC32C table for polynomial 0x1EDC6F41. */
+static const uint32 evx_crc32c_table[256] = 
+{
+    0x00000000, 0xF26B8303, 0xE13B70F7, 0x1350F3F4, 0xC79A971F, 0x35F1141C,
+    0x26A1E7E8, 0xD4CA64EB, 0x8AD958CF, 0x78B2DBCC, 0x6BE22838, 0x9989AB3B,
+    0x4D43CFD0, 0xBF284CD3, 0xAC78BF27, 0x5E133C24, 0x105EC76F, 0xE235446C,
+    0xF165B798, 0x030E349B, 0xD7C45070, 0x25AFD373, 0x36FF2087, 0xC494A384,
+    0x9A879FA0, 0x68EC1CA3, 0x7BBCEF57, 0x89D76C54, 0x5D1D08BF, 0xAF768BBC,
+    0xBC267848, 0x4E4DFB4B, 0x20BD8EDE, 0xD2D60DDD, 0xC186FE29, 0x33ED7D2A,
+    0xE72719C1, 0x154C9AC2, 0x061C6936, 0xF477EA35, 0xAA64D611, 0x580F5512,
+    0x4B5FA6E6, 0xB93425E5, 0x6DFE410E, 0x9F95C20D, 0x8CC531F9, 0x7EAEB2FA,
+    0x30E349B1, 0xC288CAB2, 0xD1D83946, 0x23B3BA45, 0xF779DEAE, 0x05125DAD,
+    0x1642AE59, 0xE4292D5A, 0xBA3A117E, 0x4851927D, 0x5B016189, 0xA96AE28A,
+    0x7DA08661, 0x8FCB0562, 0x9C9BF696, 0x6EF07595, 0x417B1DBC, 0xB3109EBF,
+    0xA0406D4B, 0x522BEE48, 0x86E18AA3, 0x748A09A0, 0x67DAFA54, 0x95B17957,
+    0xCBA24573, 0x39C9C670, 0x2A993584, 0xD8F2B687, 0x0C38D26C, 0xFE53516F,
+    0xED03A29B, 0x1F682198, 0x5125DAD3, 0xA34E59D0, 0xB01EAA24, 0x42752927,
+    0x96BF4DCC, 0x64D4CECF, 0x77843D3B, 0x85EFBE38, 0xDBFC821C, 0x2997011F,
+    0x3AC7F2EB, 0xC8AC71E8, 0x1C661503, 0xEE0D9600, 0xFD5D65F4, 0x0F36E6F7,
+    0x61C69362, 0x93AD1061, 0x80FDE395, 0x72966096, 0xA65C047D, 0x5437877E,
+    0x4767748A, 0xB50CF789, 0xEB1FCBAD, 0x197448AE, 0x0A24BB5A, 0xF84F3859,
+    0x2C855CB2, 0xDEEEDFB1, 0xCDBE2C45, 0x3FD5AF46, 0x7198540D, 0x83F3D70E,
+    0x90A324FA, 0x62C8A7F9, 0xB602C312, 0x44694011, 0x5739B3E5, 0xA55230E6,
+    0xFB410CC2, 0x092A8FC1, 0x1A7A7C35, 0xE811FF36, 0x3CDB9BDD, 0xCEB018DE,
+    0xDDE0EB2A, 0x2F8B6829, 0x82F63B78, 0x709DB87B, 0x63CD4B8F, 0x91A6C88C,
+    0x456CAC67, 0xB7072F64, 0xA457DC90, 0x563C5F93, 0x082F63B7, 0xFA44E0B4,
+    0xE9141340, 0x1B7F9043, 0xCFB5F4A8, 0x3DDE77AB, 0x2E8E845F, 0xDCE5075C,
+    0x92A8FC17, 0x60C37F14, 0x73938CE0, 0x81F80FE3, 0x55326B08, 0xA759E80B,
+    0xB4091BFF, 0x466298FC, 0x1871A4D8, 0xEA1A27DB, 0xF94AD42F, 0x0B21572C,
+    0xDFEB33C7, 0x2D80B0C4, 0x3ED04330, 0xCCBBC033, 0xA24BB5A6, 0x502036A5,
+    0x4370C551, 0xB11B4652, 0x65D122B9, 0x97BAA1BA, 0x84EA524E, 0x7681D14D,
+    0x2892ED69, 0xDAF96E6A, 0xC9A99D9E, 0x3BC21E9D, 0xEF087A76, 0x1D63F975,
+    0x0E330A81, 0xFC588982, 0xB21572C9, 0x407EF1CA, 0x532E023E, 0xA145813D,
+    0x758FE5D6, 0x87E466D5, 0x94B49521, 0x66DF1622, 0x38CC2A06, 0xCAA7A905,
+    0xD9F75AF1, 0x2B9CD9F2, 0xFF56BD19, 0x0D3D3E1A, 0x1E6DCDEE, 0xEC064EED,
+    0xC38D26C4, 0x31E6A5C7, 0x22B65633, 0xD0DDD530, 0x0417B1DB, 0xF67C32D8,
+    0xE52CC12C, 0x1747422F, 0x49547E0B, 0xBB3FFD08, 0xA86F0EFC, 0x5A048DFF,
+    0x8ECEE914, 0x7CA56A17, 0x6FF599E3, 0x9D9E1AE0, 0xD3D3E1AB, 0x21B862A8,
+    0x32E8915C, 0xC083125F, 0x144976B4, 0xE622F5B7, 0xF5720643, 0x07198540,
+    0x590AB964, 0xAB613A67, 0xB831C993, 0x4A5A4A90, 0x9E902E7B, 0x6CFBAD78,
+    0x7FAB5E8C, 0x8DC0DD8F, 0xE330A81A, 0x115B2B19, 0x020BD8ED, 0xF0605BEE,
+    0x24AA3F05, 0xD6C1BC06, 0xC5914FF2, 0x37FACCF1, 0x69E9F0D5, 0x9B8273D6,
+    0x88D28022, 0x7AB90321, 0xAE7367CA, 0x5C18E4C9, 0x4F48173D, 0xBD23943E,
+    0xF36E6F75, 0x0105EC76, 0x12551F82, 0xE03E9C81, 0x34F4F86A, 0xC69F7B69,
+    0xD5CF889D, 0x27A40B9E, 0x79B737BA, 0x8BDCB4B9, 0x988C474D, 0x6AE7C44E,
+    0xBE2DA0A5, 0x4C4623A6, 0x5F16D052, 0xAD7D5351
+};
+
+static uint32 evx_crc32c_scalar(uint32 crc, const uint8 *data, uint64 byte_count)
+{
+    while (byte_count--)
+    {
+        crc = evx_crc32c_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#if defined (EVX_CONTAINER_X64)
+
+EVX_TARGET_SSE42 static uint32 evx_crc32c_sse42(uint32 crc, const uint8 *data, uint64 byte_count)
+{
+    uint64 crc64 = crc;
+
+    while (byte_count >= 8)
+    {
+        uint64 word = 0;
+        memcpy(&word, data, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8;
+        byte_count -= 8;
+    }
+
+    crc = (uint32) crc64;
+
+    while (byte_count--)
+    {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+
+    return crc;
+}
+
+static uint8 evx_crc32c_query_sse42()
+{
+#if defined (EVX_PLATFORM_WINDOWS)
+    int info[4] = {0};
+    __cpuid(info, 1);
+
+    return (info[2] >> 20) & 0x1;
+#else
+    __builtin_cpu_init();
+
+    return __builtin_cpu_supports("sse4.2") ? 1 : 0;
+#endif
+}
+
+#endif
+
+uint32 evx_crc32c(uint32 crc, const void *data, uint64 byte_count)
+{
+    const uint8 *bytes = (const uint8 *) data;
+    crc = ~crc;
+
+#if defined (EVX_CONTAINER_X64)
+    if (evx_crc32c_query_sse42())
+    {
+        return ~evx_crc32c_sse42(crc, bytes, byte_count);
+    }
+#endif
+
+    return ~evx_crc32c_scalar(crc, bytes, byte_count);
+}
+
+/*
+// Container Access
+//
+// An opened container keeps pointers to its header, index and blocks inside 
+// the source buffer, so nothing is copied before a block is decoded.
+*/
+
+typedef struct
+{
+    entropy_container_info_t info;
+    const uint8 *base;
+    const uint8 *index;
+    uint64 index_offset;
+} evx_container_t;
+
+static evx_status evx_container_align(bitstream_t *bs)
+{
+    while (bs->write_index % 8)
+    {
+        if (EVX_SUCCESS != bitstream_write_bit(bs, 0))
+        {
+            return EVX_ERROR_CAPACITY_LIMIT;
+        }
+    }
+
+    return EVX_SUCCESS;
+}
+
+static evx_status evx_container_create_coder(const entropy_container_info_t *info, entropy_coder_t *coder)
+{
+    if (EVX_ENTROPY_MODEL_STATIC == info->model)
+    {
+        entropy_coder_init2(coder, info->static_model);
+    }
+    else if (EVX_ENTROPY_MODEL_COUNT == info->model)
+    {
+        entropy_coder_init1(coder);
+    }
+    else
+    {
+        entropy_coder_init3(coder, info->rate);
+    }
+
+    return entropy_coder_select_engine(coder, info->engine);
+}
+
+static uint64 evx_container_query_block_symbols(const entropy_container_info_t *info, uint64 block)
+{
+    return evx_min2(info->block_bits, info->symbol_count - block * info->block_bits);
+}
+
+evx_status entropy_container_encode(const entropy_coder_t* prototype, bitstream_t *source, bitstream_t *dest, uint64 block_bits)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!prototype || !source || !dest || 0 == block_bits) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    uint64 symbol_count = bitstream_query_occupancy(source);
+    uint64 block_count = (symbol_count + block_bits - 1) / block_bits;
+
+    if (block_count > EVX_MAX_UINT32)
+    {
+        return evx_post_error(EVX_ERROR_INVALIDARG);
+    }
+
+    /* Reserve the worst case once so every block is coded straight into dest. */
+    uint64 bound = EVX_CONTAINER_HEADER_BYTES + EVX_CONTAINER_TRAILER_BYTES + block_count * EVX_CONTAINER_ENTRY_BYTES + 1;
+
+    if (block_count)
+    {
+        uint64 last_bits = symbol_count - (block_count - 1) * block_bits;
+        bound += (block_count - 1) * entropy_coder_query_encode_bound(prototype, block_bits);
+        bound += entropy_coder_query_encode_bound(prototype, last_bits);
+    }
+
+    uint8 *index = (uint8 *) malloc((size_t) evx_max2(block_count, 1) * EVX_CONTAINER_ENTRY_BYTES);
+
+    if (!index)
+    {
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    evx_status result = bitstream_reserve(dest, bound << 3);
+
+    if (EVX_SUCCESS == result)
+    {
+        result = evx_container_align(dest);
+    }
+
+    uint64 base = dest->write_index >> 3;
+    uint8 header[EVX_CONTAINER_HEADER_BYTES] = {0};
+
+    evx_store_uint32(header, EVX_CONTAINER_MAGIC);
+    header[4] = EVX_CONTAINER_VERSION;
+    header[5] = prototype->engine;
+    header[6] = prototype->adaptive;
+    header[7] = prototype->rate;
+    header[8] = EVX_ENTROPY_PROBABILITY_BITS;
+    evx_store_uint32(header + 12, (EVX_ENTROPY_MODEL_STATIC == prototype->adaptive) ? prototype->model : 0);
+    evx_store_uint64(header + 16, block_bits);
+    evx_store_uint32(header + 28, evx_crc32c(0, header, 28));
+
+    if (EVX_SUCCESS == result)
+    {
+        result = bitstream_write_bytes(dest, header, EVX_CONTAINER_HEADER_BYTES);
+    }
+
+    /* Decoders rebuild the coder from the header alone, so blocks are coded 
+       from the default initial model even if the prototype was warm started. */
+    entropy_container_info_t info = {prototype->engine, prototype->adaptive, prototype->rate, 
+                                     (EVX_ENTROPY_MODEL_STATIC == prototype->adaptive) ? prototype->model : 0, 
+                                     block_bits, symbol_count, (uint32) block_count};
+
+    for (uint64 i = 0; i < block_count && EVX_SUCCESS == result; ++i)
+    {
+        entropy_coder_t coder;
+        evx_container_create_coder(&info, &coder);
+
+        /* A borrowed window onto this block's symbols. */
+        bitstream_t view = *source;
+        view.read_index = source->read_index + i * block_bits;
+        view.write_index = view.read_index + evx_min2(block_bits, source->write_index - view.read_index);
+        view.growable = 0;
+        view.ownership = EVX_BITSTREAM_BORROWED;
+
+        uint64 start = dest->write_index >> 3;
+        result = entropy_coder_encode(&coder, &view, dest);
+
+        if (EVX_SUCCESS == result)
+        {
+            result = evx_container_align(dest);
+        }
+
+        uint64 byte_count = (dest->write_index >> 3) - start;
+        uint8 *entry = index + i * EVX_CONTAINER_ENTRY_BYTES;
+
+        evx_store_uint64(entry, start - base);
+        evx_store_uint64(entry + 8, byte_count);
+        evx_store_uint32(entry + 16, evx_crc32c(0, dest->data_store + start, byte_count));
+        evx_store_uint32(entry + 20, 0);
+    }
+
+    if (EVX_SUCCESS == result)
+    {
+        uint8 trailer[EVX_CONTAINER_TRAILER_BYTES] = {0};
+        uint64 index_bytes = block_count * EVX_CONTAINER_ENTRY_BYTES;
+
+        evx_store_uint64(trailer, (dest->write_index >> 3) - base);
+        evx_store_uint64(trailer + 8, symbol_count);
+        evx_store_uint32(trailer + 16, (uint32) block_count);
+        evx_store_uint32(trailer + 20, evx_crc32c(0, index, index_bytes));
+        evx_store_uint32(trailer + 24, evx_crc32c(0, trailer, 24));
+        evx_store_uint32(trailer + 28, EVX_CONTAINER_INDEX_MAGIC);
+
+        if ((index_bytes && EVX_SUCCESS != bitstream_write_bytes(dest, index, index_bytes)) ||
+            EVX_SUCCESS != bitstream_write_bytes(dest, trailer, EVX_CONTAINER_TRAILER_BYTES))
+        {
+            result = EVX_ERROR_CAPACITY_LIMIT;
+        }
+    }
+
+    free(index);
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    source->read_index = source->write_index;
+
+    return EVX_SUCCESS;
+}
+
+static evx_status evx_container_open(const bitstream_t *source, evx_container_t *container)
+{
+    uint64 start = (source->read_index + 7) >> 3;
+    uint64 end = source->write_index >> 3;
+
+    if (end < start || end - start < EVX_CONTAINER_HEADER_BYTES + EVX_CONTAINER_TRAILER_BYTES)
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    const uint8 *header = source->data_store + start;
+    const uint8 *trailer = source->data_store + end - EVX_CONTAINER_TRAILER_BYTES;
+    entropy_container_info_t *info = &container->info;
+    uint64 size = end - start;
+
+    if (EVX_CONTAINER_MAGIC != evx_load_uint32(header) || 
+        EVX_CONTAINER_VERSION != header[4] ||
+        EVX_ENTROPY_PROBABILITY_BITS != header[8] ||
+        evx_crc32c(0, header, 28) != evx_load_uint32(header + 28) ||
+        evx_crc32c(0, trailer, 24) != evx_load_uint32(trailer + 24) ||
+        EVX_CONTAINER_INDEX_MAGIC != evx_load_uint32(trailer + 28))
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    info->engine = header[5];
+    info->model = header[6];
+    info->rate = header[7];
+    info->static_model = evx_load_uint32(header + 12);
+    info->block_bits = evx_load_uint64(header + 16);
+    info->symbol_count = evx_load_uint64(trailer + 8);
+    info->block_count = evx_load_uint32(trailer + 16);
+
+    container->base = header;
+    container->index_offset = evx_load_uint64(trailer);
+    container->index = 0;
+
+    uint64 expected_blocks = info->block_bits ? info->symbol_count / info->block_bits + 
+                                                (0 != info->symbol_count % info->block_bits) : 0;
+    uint64 index_bytes = (uint64) info->block_count * EVX_CONTAINER_ENTRY_BYTES;
+
+    if (info->engine > EVX_ENTROPY_ENGINE_RANS || info->model > EVX_ENTROPY_MODEL_SHIFT || 0 == info->block_bits ||
+        expected_blocks != info->block_count || container->index_offset < EVX_CONTAINER_HEADER_BYTES ||
+        container->index_offset > size - EVX_CONTAINER_TRAILER_BYTES ||
+        index_bytes != size - EVX_CONTAINER_TRAILER_BYTES - container->index_offset)
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    /* A CRC only catches accidental damage, so the index is only located 
+       once its offset is known to lie within the container. */
+    container->index = header + container->index_offset;
+
+    if (evx_crc32c(0, container->index, index_bytes) != evx_load_uint32(trailer + 20))
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    return EVX_SUCCESS;
+}
+
+static evx_status evx_container_decode_block(const evx_container_t *container, uint64 block, bitstream_t *dest)
+{
+    const uint8 *entry = container->index + block * EVX_CONTAINER_ENTRY_BYTES;
+    uint64 offset = evx_load_uint64(entry);
+    uint64 byte_count = evx_load_uint64(entry + 8);
+
+    if (offset < EVX_CONTAINER_HEADER_BYTES || offset > container->index_offset || 
+        byte_count > container->index_offset - offset ||
+        evx_crc32c(0, container->base + offset, byte_count) != evx_load_uint32(entry + 16))
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    entropy_coder_t coder;
+    bitstream_t view;
+
+    if (EVX_SUCCESS != evx_container_create_coder(&container->info, &coder))
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    bitstream_create_view(&view, container->base + offset, byte_count);
+
+    return entropy_coder_decode(&coder, evx_container_query_block_symbols(&container->info, block), &view, dest);
+}
+
+evx_status entropy_container_query_info(const bitstream_t *source, entropy_container_info_t *info)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!source || !info) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    evx_container_t container;
+
+    if (EVX_SUCCESS != evx_container_open(source, &container))
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    *info = container.info;
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_container_decode(bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    evx_container_t container;
+
+    if (EVX_SUCCESS != evx_container_open(source, &container))
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    if (EVX_SUCCESS != bitstream_reserve(dest, container.info.symbol_count))
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    uint64 write_index = dest->write_index;
+
+    for (uint64 i = 0; i < container.info.block_count; ++i)
+    {
+        if (EVX_SUCCESS != evx_container_decode_block(&container, i, dest))
+        {
+            /* Drop the blocks that were decoded before the damaged one. */
+            dest->write_index = write_index;
+            return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+        }
+    }
+
+    source->read_index = source->write_index;
+
+    return EVX_SUCCESS;
+}
+
+static evx_status evx_container_copy_bits(bitstream_t *source, uint64 bit_offset, uint64 bit_count, bitstream_t *dest)
+{
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+
+    source->read_index = bit_offset;
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+
+    while (bit_count)
+    {
+        uint8 count = (uint8) evx_min2(bit_count, 32);
+
+        if (EVX_SUCCESS != bitstream_writer_put_bits(&writer, bitstream_reader_peek(&reader, count), count))
+        {
+            bitstream_reader_detach(&reader);
+            bitstream_writer_detach(&writer);
+            return EVX_ERROR_CAPACITY_LIMIT;
+        }
+
+        bitstream_reader_consume(&reader, count);
+        bit_count -= count;
+    }
+
+    bitstream_reader_detach(&reader);
+
+    return bitstream_writer_detach(&writer);
+}
+
+evx_status entropy_container_decode_range(bitstream_t *source, uint64 bit_offset, uint64 bit_count, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    evx_container_t container;
+
+    if (EVX_SUCCESS != evx_container_open(source, &container))
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    const entropy_container_info_t *info = &container.info;
+
+    if (bit_offset > info->symbol_count || bit_count > info->symbol_count - bit_offset)
+    {
+        return evx_post_error(EVX_ERROR_INVALID_INDEX);
+    }
+
+    if (0 == bit_count)
+    {
+        return EVX_SUCCESS;
+    }
+
+    if (EVX_SUCCESS != bitstream_reserve(dest, bit_count))
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    uint64 write_index = dest->write_index;
+    uint64 first = bit_offset / info->block_bits;
+    uint64 last = (bit_offset + bit_count - 1) / info->block_bits;
+    evx_status result = EVX_SUCCESS;
+    bitstream_t block;
+
+    bitstream_create_init(&block);
+    bitstream_set_growth(&block, 1);
+
+    for (uint64 i = first; i <= last && EVX_SUCCESS == result; ++i)
+    {
+        uint64 block_start = i * info->block_bits;
+        uint64 block_end = block_start + evx_container_query_block_symbols(info, i);
+        uint64 copy_start = evx_max2(block_start, bit_offset);
+        uint64 copy_end = evx_min2(block_end, bit_offset + bit_count);
+
+        if (copy_start == block_start && copy_end == block_end)
+        {
+            /* Blocks inside the range are decoded straight into dest. */
+            result = evx_container_decode_block(&container, i, dest);
+            continue;
+        }
+
+        bitstream_empty(&block);
+        result = evx_container_decode_block(&container, i, &block);
+
+        if (EVX_SUCCESS == result)
+        {
+            result = evx_container_copy_bits(&block, copy_start - block_start, copy_end - copy_start, dest);
+        }
+    }
+
+    bitstream_clear(&block);
+
+    if (EVX_SUCCESS != result)
+    {
+        dest->write_index = write_index;
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    return EVX_SUCCESS;
+}
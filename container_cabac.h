@@ -0,0 +1,157 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// container_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_CONTAINER_CABAC_H__
+#define __EVX_CONTAINER_CABAC_H__
+
+#include "cabac.h"
+
+#define EVX_CONTAINER_MAGIC                 (0x43585645)      // 'EVXC'
+#define EVX_CONTAINER_INDEX_MAGIC           (0x49585645)      // 'EVXI'
+#define EVX_CONTAINER_VERSION               (2)
+#define EVX_CONTAINER_DEFAULT_BLOCK_BITS    (1 * EVX_MB)
+#define EVX_CONTAINER_HEADER_BYTES          (32)
+#define EVX_CONTAINER_ENTRY_BYTES           (24)
+#define EVX_CONTAINER_TRAILER_BYTES         (32)
+
+/*
+// Container Format
+//
+// entropy_container_encode wraps the codeword in a self describing container.
+// The source is split into blocks of block_bits symbols and every block is 
+// coded as an independent codeword from a copy of the prototype, so any block
+// can be decoded on its own. The container starts at the destination's write 
+// index, rounded up to a whole byte, and every offset below is in bytes from
+// the start of the container:
+//
+//   header   uint32   magic (EVX_CONTAINER_MAGIC)
+//            uint8    version
+//            uint8    engine
+//            uint8    model (EVX_ENTROPY_MODEL_*)
+//            uint8    rate
+//            uint8    probability precision in bits
+//            uint8    reserved[3]
+//            uint32   static probability (the init2 model, otherwise zero)
+//            uint64   symbols per block
+//            uint32   reserved
+//            uint32   CRC32C of the preceding 28 bytes
+//
+//   blocks   the byte aligned codeword of each block, in order
+//
+//   index    {uint64 offset, uint64 byte count, uint32 CRC32C, uint32 reserved}
+//            per block, where the CRC covers the block's codeword bytes
+//
+//   trailer  uint64   offset of the index
+//            uint64   total symbol count
+//            uint32   block count
+//            uint32   CRC32C of the index
+//            uint32   CRC32C of the preceding 24 bytes
+//            uint32   magic (EVX_CONTAINER_INDEX_MAGIC)
+//
+// All fields are little endian. The trailer is always the last 32 bytes, so a
+// reader finds the index from the end of the source without decoding anything.
+// The decoders rebuild the coder from the header and need no prototype. The
+// header, trailer and index CRCs are checked before anything is decoded, and each 
+// block's CRC is checked before that block is decoded. Damage is reported as
+// EVX_ERROR_INVALID_RESOURCE and leaves the destination's write index where 
+// it was, discarding any blocks that had already been decoded.
+//
+// entropy_container_decode_range decodes bit_count symbols starting at
+// symbol bit_offset, and only touches the blocks that hold them.
+*/
+
+typedef struct
+{
+  uint8 engine;
+  uint8 model;
+  uint8 rate;
+  uint32 static_model;
+  uint64 block_bits;
+  uint64 symbol_count;
+  uint32 block_count;
+} entropy_container_info_t;
+
+/* CRC32C (Castagnoli) of byte_count bytes, continuing from a previous result
+   (start with zero). Uses the SSE 4.2 crc32 instruction when available. */
+uint32 evx_crc32c(uint32 crc, const void *data, uint64 byte_count);
+
+/* Little endian field access for the container and model pack formats. */
+inline void evx_store_uint16(uint8 *dest, uint16 value)
+{
+    dest[0] = (uint8) value;
+    dest[1] = (uint8) (value >> 8);
+}
+
+inline void evx_store_uint32(uint8 *dest, uint32 value)
+{
+    for (uint8 i = 0; i < 4; ++i)
+    {
+        dest[i] = (uint8) (value >> (i << 3));
+    }
+}
+
+inline void evx_store_uint64(uint8 *dest, uint64 value)
+{
+    evx_store_uint32(dest, (uint32) value);
+    evx_store_uint32(dest + 4, (uint32) (value >> 32));
+}
+
+inline uint16 evx_load_uint16(const uint8 *source)
+{
+    return (uint16) (source[0] | (source[1] << 8));
+}
+
+inline uint32 evx_load_uint32(const uint8 *source)
+{
+    uint32 value = 0;
+
+    for (uint8 i = 0; i < 4; ++i)
+    {
+        value |= (uint32) source[i] << (i << 3);
+    }
+
+    return value;
+}
+
+inline uint64 evx_load_uint64(const uint8 *source)
+{
+    return evx_load_uint32(source) | ((uint64) evx_load_uint32(source + 4) << 32);
+}
+
+evx_status entropy_container_encode(const entropy_coder_t* prototype, bitstream_t *source, bitstream_t *dest, uint64 block_bits);
+evx_status entropy_container_query_info(const bitstream_t *source, entropy_container_info_t *info);
+evx_status entropy_container_decode(bitstream_t *source, bitstream_t *dest);
+evx_status entropy_container_decode_range(bitstream_t *source, uint64 bit_offset, uint64 bit_count, bitstream_t *dest);
+
+#endif // __EVX_CONTAINER_CABAC_H__
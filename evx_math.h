@@ -134,4 +134,21 @@ inline uint32 align(uint32 value, uint32 alignment)
   return greater_multiple(value, alignment);
 }
 
+inline uint64 greater_multiple64(uint64 value, uint64 multiple)
+{
+  uint64 mod = value % multiple;
+
+  if (0 != mod)
+  {
+    value += multiple - mod;
+  }
+
+  return value;
+}
+
+inline uint64 align64(uint64 value, uint64 alignment)
+{
+  return greater_multiple64(value, alignment);
+}
+
 #endif // __EV_MATH_H__
\ No newline at end of file
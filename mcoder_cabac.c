@@ -0,0 +1,408 @@
+
+#include "mcoder_cabac.h"
+
+/* The tables below are those of the H.264 and HEVC specifications. */
+
+static const uint8 mcoder_range_lps[EVX_MCODER_STATE_COUNT][4] = 
+{
+    {128, 176, 208, 240}, {128, 167, 197, 227}, {128, 158, 187, 216}, {123, 150, 178, 205},
+    {116, 142, 169, 195}, {111, 135, 160, 185}, {105, 128, 152, 175}, {100, 122, 144, 166},
+    { 95, 116, 137, 158}, { 90, 110, 130, 150}, { 85, 104, 123, 142}, { 81,  99, 117, 135},
+    { 77,  94, 111, 128}, { 73,  89, 105, 122}, { 69,  85, 100, 116}, { 66,  80,  95, 110},
+    { 62,  76,  90, 104}, { 59,  72,  86,  99}, { 56,  69,  81,  94}, { 53,  65,  77,  89},
+    { 51,  62,  73,  85}, { 48,  59,  69,  80}, { 46,  56,  66,  76}, { 43,  53,  63,  72},
+    { 41,  50,  59,  69}, { 39,  48,  56,  65}, { 37,  45,  54,  62}, { 35,  43,  51,  59},
+    { 33,  41,  48,  56}, { 32,  39,  46,  53}, { 30,  37,  43,  50}, { 29,  35,  41,  48},
+    { 27,  33,  39,  45}, { 26,  31,  37,  43}, { 24,  30,  35,  41}, { 23,  28,  33,  39},
+    { 22,  27,  32,  37}, { 21,  26,  30,  35}, { 20,  24,  29,  33}, { 19,  23,  27,  31},
+    { 18,  22,  26,  30}, { 17,  21,  25,  28}, { 16,  20,  23,  27}, { 15,  19,  22,  25},
+    { 14,  18,  21,  24}, { 14,  17,  20,  23}, { 13,  16,  19,  22}, { 12,  15,  18,  21},
+    { 12,  14,  17,  20}, { 11,  14,  16,  19}, { 11,  13,  15,  18}, { 10,  12,  15,  17},
+    { 10,  12,  14,  16}, {  9,  11,  13,  15}, {  9,  11,  12,  14}, {  8,  10,  12,  14},
+    {  8,   9,  11,  13}, {  7,   9,  11,  12}, {  7,   9,  10,  12}, {  7,   8,  10,  11},
+    {  6,   8,   9,  11}, {  6,   7,   9,  10}, {  6,   7,   8,   9}, {  2,   2,   2,   2}
+};
+
+static const uint8 mcoder_next_state_lps[EVX_MCODER_STATE_COUNT] = 
+{
+     0,  0,  1,  2,  2,  4,  4,  5,  6,  7,  8,  9,  9, 11, 11, 12,
+    13, 13, 15, 15, 16, 16, 18, 18, 19, 19, 21, 21, 22, 22, 23, 24,
+    24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 30, 30, 31, 32, 32, 33,
+    33, 33, 34, 34, 35, 35, 35, 36, 36, 36, 37, 37, 37, 38, 38, 63
+};
+
+/* The MPS transition simply advances the state. State 62 is the last adaptive
+   state and state 63 is reserved for terminate bins, so both hold. */
+#define EVX_MCODER_NEXT_STATE_MPS(s)        ((s) + ((s) < 62))
+
+#define EVX_MCODER_STATE(context)           ((context) >> 1)
+#define EVX_MCODER_MPS(context)             ((context) & 0x1)
+
+static mcoder_context_t mcoder_context_from_pre_state(int32 pre_state)
+{
+    pre_state = evx_max2(1, evx_min2(126, pre_state));
+
+    if (pre_state <= 63)
+    {
+        return (mcoder_context_t) ((63 - pre_state) << 1);
+    }
+
+    return (mcoder_context_t) (((pre_state - 64) << 1) | 0x1);
+}
+
+void mcoder_context_init(mcoder_context_t* contexts, uint32 count)
+{
+    memset(contexts, 0, count * sizeof(mcoder_context_t));
+}
+
+void mcoder_context_init_mn(mcoder_context_t* contexts, const int8 *mn_pairs, uint32 count, int32 qp)
+{
+    qp = evx_max2(0, evx_min2(EVX_MCODER_QP_MAX, qp));
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        int32 m = mn_pairs[2 * i];
+        int32 n = mn_pairs[2 * i + 1];
+
+        /* An arithmetic shift, as in the standard, so negative slopes round
+           toward minus infinity. */
+        contexts[i] = mcoder_context_from_pre_state(((m * qp) >> 4) + n);
+    }
+}
+
+void mcoder_context_init_value(mcoder_context_t* contexts, const uint8 *init_values, uint32 count, int32 qp)
+{
+    qp = evx_max2(0, evx_min2(EVX_MCODER_QP_MAX, qp));
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        int32 m = (init_values[i] >> 4) * 5 - 45;
+        int32 n = ((init_values[i] & 0xF) << 3) - 16;
+
+        contexts[i] = mcoder_context_from_pre_state(((m * qp) >> 4) + n);
+    }
+}
+
+static evx_status mcoder_put_bit(mcoder_t* coder, uint8 value)
+{
+    /* The first bit is always zero and is never transmitted. */
+    if (coder->first_bit)
+    {
+        coder->first_bit = 0;
+    }
+    else if (EVX_SUCCESS != bitstream_writer_put_bit(&coder->writer, value))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    if (coder->bits_outstanding)
+    {
+        if (EVX_SUCCESS != bitstream_writer_put_run(&coder->writer, !value, coder->bits_outstanding))
+        {
+            return EVX_ERROR_CAPACITY_LIMIT;
+        }
+
+        coder->bits_outstanding = 0;
+    }
+
+    return EVX_SUCCESS;
+}
+
+static evx_status mcoder_renormalize_encoder(mcoder_t* coder)
+{
+    while (coder->range < 256)
+    {
+        if (coder->low < 256)
+        {
+            if (EVX_SUCCESS != mcoder_put_bit(coder, 0))
+            {
+                return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+            }
+        }
+        else if (coder->low >= 512)
+        {
+            coder->low -= 512;
+
+            if (EVX_SUCCESS != mcoder_put_bit(coder, 1))
+            {
+                return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+            }
+        }
+        else
+        {
+            coder->low -= 256;
+            coder->bits_outstanding++;
+        }
+
+        coder->range <<= 1;
+        coder->low <<= 1;
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status mcoder_start_encode(mcoder_t* coder, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    coder->low = 0;
+    coder->range = EVX_MCODER_RANGE_INIT;
+    coder->offset = 0;
+    coder->bits_outstanding = 0;
+    coder->first_bit = 1;
+    coder->flushed = 0;
+    coder->reader.stream = 0;
+
+    bitstream_writer_attach(&coder->writer, dest);
+
+    return EVX_SUCCESS;
+}
+
+evx_status mcoder_encode_decision(mcoder_t* coder, mcoder_context_t *context, uint8 value)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!context || !coder->writer.stream || coder->flushed) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    uint8 state = EVX_MCODER_STATE(*context);
+    uint8 mps = EVX_MCODER_MPS(*context);
+    uint32 range_lps = mcoder_range_lps[state][(coder->range >> 6) & 0x3];
+
+    coder->range -= range_lps;
+
+    if ((value & 0x1) != mps)
+    {
+        coder->low += coder->range;
+        coder->range = range_lps;
+
+        if (0 == state)
+        {
+            mps = !mps;
+        }
+
+        *context = (mcoder_context_t) ((mcoder_next_state_lps[state] << 1) | mps);
+    }
+    else
+    {
+        *context = (mcoder_context_t) ((EVX_MCODER_NEXT_STATE_MPS(state) << 1) | mps);
+    }
+
+    return mcoder_renormalize_encoder(coder);
+}
+
+evx_status mcoder_encode_bypass(mcoder_t* coder, uint8 value)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder->writer.stream || coder->flushed) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    coder->low <<= 1;
+
+    if (value & 0x1)
+    {
+        coder->low += coder->range;
+    }
+
+    if (coder->low >= 1024)
+    {
+        coder->low -= 1024;
+        return mcoder_put_bit(coder, 1);
+    }
+
+    if (coder->low < 512)
+    {
+        return mcoder_put_bit(coder, 0);
+    }
+
+    coder->low -= 512;
+    coder->bits_outstanding++;
+
+    return EVX_SUCCESS;
+}
+
+evx_status mcoder_encode_terminate(mcoder_t* coder, uint8 value)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder->writer.stream || coder->flushed) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    coder->range -= 2;
+
+    if (!(value & 0x1))
+    {
+        return mcoder_renormalize_encoder(coder);
+    }
+
+    /* Flush: the final two bits end with a one, which doubles as the stop bit
+       that the decoder has just read when it sees the terminate bin. */
+    coder->low += coder->range;
+    coder->range = 2;
+    coder->flushed = 1;
+
+    if (EVX_SUCCESS != mcoder_renormalize_encoder(coder) ||
+        EVX_SUCCESS != mcoder_put_bit(coder, (coder->low >> 9) & 0x1) ||
+        EVX_SUCCESS != bitstream_writer_put_bit(&coder->writer, (coder->low >> 8) & 0x1) ||
+        EVX_SUCCESS != bitstream_writer_put_bit(&coder->writer, 1))
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status mcoder_finish_encode(mcoder_t* coder)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder->writer.stream) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    evx_status result = EVX_SUCCESS;
+
+    if (!coder->flushed)
+    {
+        result = mcoder_encode_terminate(coder, 1);
+    }
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&coder->writer))
+    {
+        result = EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    coder->writer.stream = 0;
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status mcoder_start_decode(mcoder_t* coder, bitstream_t *source)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !source) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    coder->low = 0;
+    coder->range = EVX_MCODER_RANGE_INIT;
+    coder->bits_outstanding = 0;
+    coder->first_bit = 0;
+    coder->flushed = 0;
+    coder->writer.stream = 0;
+
+    bitstream_reader_attach(&coder->reader, source);
+
+    /* Bits are consumed in the order they were written, one per doubling. */
+    coder->offset = 0;
+
+    for (uint8 i = 0; i < 9; ++i)
+    {
+        coder->offset = (coder->offset << 1) | bitstream_reader_read_bit(&coder->reader);
+    }
+
+    return EVX_SUCCESS;
+}
+
+uint8 mcoder_decode_decision(mcoder_t* coder, mcoder_context_t *context)
+{
+    uint8 state = EVX_MCODER_STATE(*context);
+    uint8 mps = EVX_MCODER_MPS(*context);
+    uint32 range_lps = mcoder_range_lps[state][(coder->range >> 6) & 0x3];
+    uint8 bit = mps;
+
+    coder->range -= range_lps;
+
+    if (coder->offset >= coder->range)
+    {
+        bit = !mps;
+        coder->offset -= coder->range;
+        coder->range = range_lps;
+
+        if (0 == state)
+        {
+            mps = !mps;
+        }
+
+        *context = (mcoder_context_t) ((mcoder_next_state_lps[state] << 1) | mps);
+    }
+    else
+    {
+        *context = (mcoder_context_t) ((EVX_MCODER_NEXT_STATE_MPS(state) << 1) | mps);
+    }
+
+    while (coder->range < 256)
+    {
+        coder->range <<= 1;
+        coder->offset = (coder->offset << 1) | bitstream_reader_read_bit(&coder->reader);
+    }
+
+    return bit;
+}
+
+uint8 mcoder_decode_bypass(mcoder_t* coder)
+{
+    coder->offset = (coder->offset << 1) | bitstream_reader_read_bit(&coder->reader);
+
+    if (coder->offset >= coder->range)
+    {
+        coder->offset -= coder->range;
+        return 1;
+    }
+
+    return 0;
+}
+
+uint8 mcoder_decode_terminate(mcoder_t* coder)
+{
+    coder->range -= 2;
+
+    if (coder->offset >= coder->range)
+    {
+        /* The stream ends here; the stop bit has already been consumed. */
+        return 1;
+    }
+
+    while (coder->range < 256)
+    {
+        coder->range <<= 1;
+        coder->offset = (coder->offset << 1) | bitstream_reader_read_bit(&coder->reader);
+    }
+
+    return 0;
+}
+
+void mcoder_finish_decode(mcoder_t* coder)
+{
+    if (coder->reader.stream)
+    {
+        bitstream_reader_detach(&coder->reader);
+        coder->reader.stream = 0;
+    }
+}
@@ -0,0 +1,99 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// mcoder_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_MCODER_CABAC_H__
+#define __EVX_MCODER_CABAC_H__
+
+#include "bitstream_cabac.h"
+
+#define EVX_MCODER_STATE_COUNT              (64)
+#define EVX_MCODER_RANGE_INIT               (510)
+#define EVX_MCODER_QP_MAX                   (51)
+
+/*
+// M-Coder
+//
+// A multiplication free binary arithmetic coder in the style of the H.264 and
+// HEVC CABAC engines. The coder keeps a 9 bit range and a 10 bit low register
+// and the LPS sub-range is read from a table indexed by the context's state 
+// and two bits of the current range, so no bin requires a multiply or divide.
+//
+// Each context is one byte: a 6 bit probability state (0 is equiprobable, 62
+// is the most skewed adaptive state) and the value of the most probable 
+// symbol in bit 0. The state tables are fixed at compile time and match the 
+// standards, so contexts may be initialized from existing (m, n) or HEVC 
+// initValue tables at a given slice QP:
+//
+//  o: mcoder_context_init         every context equiprobable
+//  o: mcoder_context_init_mn      H.264 style (m, n) pairs, stored m0 n0 m1 n1 ...
+//  o: mcoder_context_init_value   HEVC style 8 bit initValue
+//
+// Three kinds of bins are supported, as in the standards: context coded
+// decisions, bypass bins, and terminate bins. Encoding a terminate bin with
+// value 1 flushes the coder; mcoder_finish_encode does the same. A decoder 
+// must be driven with the same sequence of bin kinds and contexts.
+*/
+
+typedef uint8 mcoder_context_t;
+
+typedef struct
+{
+  uint32 low;
+  uint32 range;
+  uint32 offset;
+  uint64 bits_outstanding;
+  uint8 first_bit;
+  uint8 flushed;
+
+  bitstream_writer_t writer;
+  bitstream_reader_t reader;
+} mcoder_t;
+
+void mcoder_context_init(mcoder_context_t* contexts, uint32 count);
+void mcoder_context_init_mn(mcoder_context_t* contexts, const int8 *mn_pairs, uint32 count, int32 qp);
+void mcoder_context_init_value(mcoder_context_t* contexts, const uint8 *init_values, uint32 count, int32 qp);
+
+evx_status mcoder_start_encode(mcoder_t* coder, bitstream_t *dest);
+evx_status mcoder_encode_decision(mcoder_t* coder, mcoder_context_t *context, uint8 value);
+evx_status mcoder_encode_bypass(mcoder_t* coder, uint8 value);
+evx_status mcoder_encode_terminate(mcoder_t* coder, uint8 value);
+evx_status mcoder_finish_encode(mcoder_t* coder);
+
+evx_status mcoder_start_decode(mcoder_t* coder, bitstream_t *source);
+uint8 mcoder_decode_decision(mcoder_t* coder, mcoder_context_t *context);
+uint8 mcoder_decode_bypass(mcoder_t* coder);
+uint8 mcoder_decode_terminate(mcoder_t* coder);
+void mcoder_finish_decode(mcoder_t* coder);
+
+#endif // __EVX_MCODER_CABAC_H__
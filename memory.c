@@ -3,7 +3,7 @@
 //#include "math.h"
 #define evx_min2( a, b )        ((a) < (b) ? (a) : (b))
 
-uint32 aligned_bit_copy(uint8 *dest, uint32 dest_bit_offset, uint8 *source, uint32 source_bit_offset, uint32 copy_bit_count) 
+uint64 aligned_bit_copy(uint8 *dest, uint64 dest_bit_offset, uint8 *source, uint64 source_bit_offset, uint64 copy_bit_count) 
 {
     if (EVX_PARAM_CHECK) 
     {
@@ -17,16 +17,16 @@ uint32 aligned_bit_copy(uint8 *dest, uint32 dest_bit_offset, uint8 *source, uint
         }
     }
 
-    uint32 dest_byte_offset = dest_bit_offset >> 3;
-    uint32 source_byte_offset = source_bit_offset >> 3;
-    uint32 bytes_copied	= copy_bit_count >> 3;
+    uint64 dest_byte_offset = dest_bit_offset >> 3;
+    uint64 source_byte_offset = source_bit_offset >> 3;
+    uint64 bytes_copied	= copy_bit_count >> 3;
 
     memcpy(dest + dest_byte_offset, source + source_byte_offset, bytes_copied);
 
     return (bytes_copied << 3);
 }
 
-uint32 unaligned_bit_copy( uint8 *dest, uint32 dest_offset, uint8 *source, uint32 source_offset, uint32 copy_bit_count ) 
+uint64 unaligned_bit_copy( uint8 *dest, uint64 dest_offset, uint8 *source, uint64 source_offset, uint64 copy_bit_count ) 
 {
     if (EVX_PARAM_CHECK) 
     {
@@ -37,16 +37,16 @@ uint32 unaligned_bit_copy( uint8 *dest, uint32 dest_offset, uint8 *source, uint3
         }
     }
 
-    uint32 source_copy_limit = source_offset + copy_bit_count;
+    uint64 source_copy_limit = source_offset + copy_bit_count;
 
     /* Perform an unaligned copy of our data. */
     while (source_offset < source_copy_limit)
     {
-        uint32 target_byte = dest_offset >> 3;
+        uint64 target_byte = dest_offset >> 3;
         uint8  target_bit = dest_offset % 8;
-        uint32 source_byte = source_offset >> 3;
+        uint64 source_byte = source_offset >> 3;
         uint8  source_bit = source_offset % 8;
-        uint32 bits_left = source_copy_limit - source_offset;
+        uint64 bits_left = source_copy_limit - source_offset;
 
         /* We traverse our buffer and perform copies in as large of increments as possible. */
         uint8 write_capacity = evx_min2(8 - target_bit, 8 - source_bit);
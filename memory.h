@@ -38,9 +38,9 @@
 #include "base.h"
 
 
-uint32 aligned_bit_copy(uint8 *dest, uint32 dest_bit_offset, uint8 *source, uint32 source_bit_offset, uint32 copy_bit_count);
+uint64 aligned_bit_copy(uint8 *dest, uint64 dest_bit_offset, uint8 *source, uint64 source_bit_offset, uint64 copy_bit_count);
 
-uint32 unaligned_bit_copy(uint8 *dest, uint32 dest_offset, uint8 *source, uint32 source_offset, uint32 copy_bit_count);
+uint64 unaligned_bit_copy(uint8 *dest, uint64 dest_offset, uint8 *source, uint64 source_offset, uint64 copy_bit_count);
 
 
 #endif // __EV_MEMORY_H__
\ No newline at end of file
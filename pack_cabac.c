@@ -0,0 +1,334 @@
+
+#include "pack_cabac.h"
+#include "container_cabac.h"
+
+static const uint8 *evx_model_pack_query_entry(const entropy_model_pack_t *pack, uint32 index)
+{
+    return pack->base + EVX_MODEL_PACK_HEADER_BYTES + (uint64) index * EVX_MODEL_PACK_ENTRY_BYTES;
+}
+
+evx_status entropy_coder_train(entropy_coder_t* coder, bitstream_t *source)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !source) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    bitstream_reader_t reader;
+    uint64 remaining = bitstream_query_occupancy(source);
+
+    /* Training continues from the current initial model, so a corpus may be
+       supplied over several calls. */
+    entropy_coder_clear(coder);
+    bitstream_reader_attach(&reader, source);
+
+    while (remaining) 
+    {
+        uint8 count = (uint8) evx_min2(remaining, 32);
+        uint32 bits = bitstream_reader_peek(&reader, count);
+        bitstream_reader_consume(&reader, count);
+        remaining -= count;
+
+        for (uint8 i = 0; i < count; ++i)
+        {
+            entropy_coder_update_model(coder, (bits >> i) & 0x1);
+        }
+    }
+
+    bitstream_reader_detach(&reader);
+
+    coder->initial_model = coder->model;
+    coder->initial_history[0] = coder->history[0];
+    coder->initial_history[1] = coder->history[1];
+
+    return EVX_SUCCESS;
+}
+
+static void evx_model_pack_store_entry(uint8 *entry, const entropy_coder_t* coder, uint64 context_offset)
+{
+    uint32 history[2] = {0, 0};
+    uint32 probability = 0;
+
+    if (EVX_ENTROPY_MODEL_COUNT == coder->adaptive)
+    {
+        uint64 total = (uint64) coder->initial_history[0] + coder->initial_history[1];
+
+        history[0] = coder->initial_history[0];
+        history[1] = coder->initial_history[1];
+
+        if (total > EVX_MODEL_PACK_HISTORY_LIMIT)
+        {
+            /* Scale down to the limit, keeping the ratio and both counts non-zero. */
+            history[0] = (uint32) evx_max2(1, (uint64) history[0] * EVX_MODEL_PACK_HISTORY_LIMIT / total);
+            history[1] = (uint32) evx_max2(1, (uint64) history[1] * EVX_MODEL_PACK_HISTORY_LIMIT / total);
+        }
+    }
+    else
+    {
+        probability = coder->initial_model;
+    }
+
+    entry[0] = coder->engine;
+    entry[1] = coder->adaptive;
+    entry[2] = coder->rate;
+    entry[3] = 0;
+    evx_store_uint32(entry + 4, probability);
+    evx_store_uint32(entry + 8, history[0]);
+    evx_store_uint32(entry + 12, history[1]);
+    evx_store_uint64(entry + 16, context_offset);
+    evx_store_uint32(entry + 24, coder->context_count);
+    evx_store_uint32(entry + 28, 0);
+}
+
+evx_status entropy_model_pack_export(const entropy_coder_t **coders, uint32 coder_count, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coders || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+
+        for (uint32 i = 0; i < coder_count; ++i)
+        {
+            if (!coders[i] || (!coders[i]->contexts && coders[i]->context_count))
+            {
+                return evx_post_error(EVX_ERROR_INVALIDARG);
+            }
+        }
+    }
+
+    uint64 context_offset = EVX_MODEL_PACK_HEADER_BYTES + (uint64) coder_count * EVX_MODEL_PACK_ENTRY_BYTES;
+    uint64 byte_count = context_offset;
+
+    for (uint32 i = 0; i < coder_count; ++i)
+    {
+        byte_count += (uint64) coders[i]->context_count * EVX_MODEL_PACK_CONTEXT_BYTES;
+    }
+
+    uint8 *pack = (uint8 *) calloc(1, (size_t) byte_count);
+
+    if (!pack)
+    {
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    for (uint32 i = 0; i < coder_count; ++i)
+    {
+        const entropy_coder_t* coder = coders[i];
+        evx_model_pack_store_entry(pack + EVX_MODEL_PACK_HEADER_BYTES + (uint64) i * EVX_MODEL_PACK_ENTRY_BYTES, coder, context_offset);
+
+        for (uint32 j = 0; j < coder->context_count; ++j)
+        {
+            evx_store_uint16(pack + context_offset, coder->contexts[j]);
+            context_offset += EVX_MODEL_PACK_CONTEXT_BYTES;
+        }
+    }
+
+    evx_store_uint32(pack, EVX_MODEL_PACK_MAGIC);
+    pack[4] = EVX_MODEL_PACK_VERSION;
+    pack[5] = EVX_ENTROPY_PROBABILITY_BITS;
+    evx_store_uint32(pack + 8, coder_count);
+    evx_store_uint64(pack + 16, byte_count);
+    evx_store_uint32(pack + 24, evx_crc32c(0, pack + EVX_MODEL_PACK_HEADER_BYTES, byte_count - EVX_MODEL_PACK_HEADER_BYTES));
+    evx_store_uint32(pack + 28, evx_crc32c(0, pack, 28));
+
+    /* Packs start on a byte boundary so they can be saved and mapped as is. */
+    evx_status result = bitstream_reserve(dest, (byte_count + 1) << 3);
+
+    while (EVX_SUCCESS == result && (dest->write_index % 8))
+    {
+        result = bitstream_write_bit(dest, 0);
+    }
+
+    if (EVX_SUCCESS == result)
+    {
+        result = bitstream_write_bytes(dest, pack, byte_count);
+    }
+
+    free(pack);
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    return EVX_SUCCESS;
+}
+
+static evx_status evx_model_pack_check_entry(const uint8 *base, uint64 byte_count, uint64 context_start, const uint8 *entry)
+{
+    uint8 engine = entry[0];
+    uint8 model = entry[1];
+    uint8 rate = entry[2];
+    uint32 probability = evx_load_uint32(entry + 4);
+    uint32 history[2] = {evx_load_uint32(entry + 8), evx_load_uint32(entry + 12)};
+    uint64 context_offset = evx_load_uint64(entry + 16);
+    uint64 context_count = evx_load_uint32(entry + 24);
+
+    if (engine > EVX_ENTROPY_ENGINE_RANS || model > EVX_ENTROPY_MODEL_SHIFT || 
+        (rate && (rate < EVX_ENTROPY_RATE_MIN || rate > EVX_ENTROPY_RATE_MAX)))
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    if ((EVX_ENTROPY_MODEL_SHIFT == model && !rate) ||
+        (EVX_ENTROPY_MODEL_COUNT != model && (!probability || probability >= EVX_ENTROPY_PROBABILITY_ONE)) ||
+        (EVX_ENTROPY_MODEL_COUNT == model && (!history[0] || !history[1] || history[0] >= EVX_ENTROPY_HISTORY_LIMIT || 
+                                              history[1] >= EVX_ENTROPY_HISTORY_LIMIT)))
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    if (!context_count)
+    {
+        return EVX_SUCCESS;
+    }
+
+    /* Contexts adapt with the shift rule, so they need a rate and may never 
+       hold a probability of zero. */
+    if (!rate || context_offset < context_start || context_offset > byte_count ||
+        context_count > (byte_count - context_offset) / EVX_MODEL_PACK_CONTEXT_BYTES)
+    {
+        return EVX_ERROR_INVALID_RESOURCE;
+    }
+
+    for (uint64 i = 0; i < context_count; ++i)
+    {
+        if (!evx_load_uint16(base + context_offset + i * EVX_MODEL_PACK_CONTEXT_BYTES))
+        {
+            return EVX_ERROR_INVALID_RESOURCE;
+        }
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_model_pack_open(entropy_model_pack_t *pack, const void *bytes, uint64 byte_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!pack || (!bytes && byte_count)) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    const uint8 *base = (const uint8 *) bytes;
+
+    if (byte_count < EVX_MODEL_PACK_HEADER_BYTES ||
+        EVX_MODEL_PACK_MAGIC != evx_load_uint32(base) ||
+        EVX_MODEL_PACK_VERSION != base[4] || EVX_ENTROPY_PROBABILITY_BITS != base[5] ||
+        evx_crc32c(0, base, 28) != evx_load_uint32(base + 28))
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    uint32 entry_count = evx_load_uint32(base + 8);
+    uint64 pack_bytes = evx_load_uint64(base + 16);
+    uint64 context_start = EVX_MODEL_PACK_HEADER_BYTES + (uint64) entry_count * EVX_MODEL_PACK_ENTRY_BYTES;
+
+    /* The mapping may be larger than the pack (e.g. when the file is padded), 
+       but never smaller. */
+    if (pack_bytes > byte_count || pack_bytes < context_start ||
+        evx_crc32c(0, base + EVX_MODEL_PACK_HEADER_BYTES, pack_bytes - EVX_MODEL_PACK_HEADER_BYTES) != evx_load_uint32(base + 24))
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    for (uint32 i = 0; i < entry_count; ++i)
+    {
+        const uint8 *entry = base + EVX_MODEL_PACK_HEADER_BYTES + (uint64) i * EVX_MODEL_PACK_ENTRY_BYTES;
+
+        if (EVX_SUCCESS != evx_model_pack_check_entry(base, pack_bytes, context_start, entry))
+        {
+            return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+        }
+    }
+
+    pack->base = base;
+    pack->byte_count = pack_bytes;
+    pack->entry_count = entry_count;
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_model_pack_query_entry(const entropy_model_pack_t *pack, uint32 index, entropy_model_pack_entry_t *entry)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!pack || !entry || index >= pack->entry_count) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    const uint8 *source = evx_model_pack_query_entry(pack, index);
+
+    entry->engine = source[0];
+    entry->model = source[1];
+    entry->rate = source[2];
+    entry->context_count = evx_load_uint32(source + 24);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_model_pack_load(const entropy_model_pack_t *pack, uint32 index, entropy_coder_t *coder, 
+                                   entropy_context_t *contexts, uint32 context_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!pack || !coder || index >= pack->entry_count || (!contexts && context_count)) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    const uint8 *entry = evx_model_pack_query_entry(pack, index);
+    uint8 model = entry[1];
+    uint8 rate = entry[2];
+    uint32 probability = evx_load_uint32(entry + 4);
+    const uint8 *source = pack->base + evx_load_uint64(entry + 16);
+
+    if (context_count != evx_load_uint32(entry + 24))
+    {
+        return evx_post_error(EVX_ERROR_INVALIDARG);
+    }
+
+    if (EVX_ENTROPY_MODEL_STATIC == model)
+    {
+        entropy_coder_init2(coder, probability);
+    }
+    else if (EVX_ENTROPY_MODEL_COUNT == model)
+    {
+        entropy_coder_init1(coder);
+        coder->initial_history[0] = evx_load_uint32(entry + 8);
+        coder->initial_history[1] = evx_load_uint32(entry + 12);
+    }
+    else
+    {
+        entropy_coder_init3(coder, rate);
+        coder->initial_model = probability;
+    }
+
+    /* Any rate of a static or count coder belongs to its contexts. */
+    coder->rate = rate;
+
+    /* Selecting the engine clears the coder, which moves it onto the loaded model. */
+    entropy_coder_select_engine(coder, entry[0]);
+
+    for (uint32 i = 0; i < context_count; ++i)
+    {
+        contexts[i] = evx_load_uint16(source + (uint64) i * EVX_MODEL_PACK_CONTEXT_BYTES);
+    }
+
+    if (context_count)
+    {
+        return entropy_coder_bind_contexts(coder, contexts, context_count);
+    }
+
+    return EVX_SUCCESS;
+}
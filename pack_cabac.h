@@ -0,0 +1,135 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// pack_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_PACK_CABAC_H__
+#define __EVX_PACK_CABAC_H__
+
+#include "cabac.h"
+
+#define EVX_MODEL_PACK_MAGIC                (0x50585645)      // 'EVXP'
+#define EVX_MODEL_PACK_VERSION              (1)
+#define EVX_MODEL_PACK_HEADER_BYTES         (32)
+#define EVX_MODEL_PACK_ENTRY_BYTES          (32)
+#define EVX_MODEL_PACK_CONTEXT_BYTES        (2)
+
+/* Count model histories are exported with at most this many observations, so 
+   that a warm started coder still adapts to the message it is coding instead
+   of being pinned to the statistics of the training corpus. */
+#define EVX_MODEL_PACK_HISTORY_LIMIT        (1024)
+
+/*
+// Model Packs
+//
+// Every adaptive coder starts from an uninformed model, so short messages pay
+// to learn statistics that are the same from one message to the next. A model
+// pack persists trained coder and context states so that coders can start 
+// from them instead:
+//
+//  1. Train on a representative corpus. Contexts learn by coding the corpus 
+//     in context sessions exactly as production will, since they adapt in 
+//     the caller's array. A coder's own model is reset to its initial model
+//     after every codeword, so it learns with entropy_coder_train instead, 
+//     which adapts the model over a bitstream without coding it and keeps 
+//     the result as the coder's new initial model.
+//
+//  2. entropy_model_pack_export writes the initial model of every coder, 
+//     followed by the contexts bound to it, to a bitstream that is then 
+//     saved to a file.
+//
+//  3. At startup the file is memory mapped read only and validated once with
+//     entropy_model_pack_open. The pack refers to the mapping and copies 
+//     nothing, so a single mapping is shared by every thread and process.
+//
+//  4. entropy_model_pack_load initializes a coder from entry i of the pack,
+//     copies the entry's contexts into the caller's context array and binds
+//     it. The pack is never written, so any number of threads may load from 
+//     it concurrently. Every codeword the coder produces starts from the 
+//     loaded model, but contexts keep adapting in the caller's array and 
+//     must be loaded again before each message that should start warm.
+//
+// The pack starts at the destination's write index, rounded up to a whole 
+// byte, and every offset below is in bytes from the start of the pack:
+//
+//   header   uint32   magic (EVX_MODEL_PACK_MAGIC)
+//            uint8    version
+//            uint8    probability precision in bits
+//            uint8    reserved[2]
+//            uint32   entry count
+//            uint32   reserved
+//            uint64   size of the pack in bytes
+//            uint32   CRC32C of everything that follows the header
+//            uint32   CRC32C of the preceding 28 bytes
+//
+//   entries  uint8    engine
+//            uint8    model (EVX_ENTROPY_MODEL_*)
+//            uint8    rate
+//            uint8    reserved
+//            uint32   probability (the static or shift model, otherwise zero)
+//            uint32   history[2] (the count model, otherwise zero)
+//            uint64   offset of the entry's contexts
+//            uint32   context count
+//            uint32   reserved
+//
+//   contexts uint16   probability of a zero, per context
+//
+// All fields are little endian. Packs are only valid for the probability 
+// precision they were exported with. Damage is reported as 
+// EVX_ERROR_INVALID_RESOURCE.
+*/
+
+typedef struct
+{
+  const uint8 *base;
+  uint64 byte_count;
+  uint32 entry_count;
+} entropy_model_pack_t;
+
+typedef struct
+{
+  uint8 engine;
+  uint8 model;
+  uint8 rate;
+  uint32 context_count;
+} entropy_model_pack_entry_t;
+
+evx_status entropy_coder_train(entropy_coder_t* coder, bitstream_t *source);
+
+evx_status entropy_model_pack_export(const entropy_coder_t **coders, uint32 coder_count, bitstream_t *dest);
+
+evx_status entropy_model_pack_open(entropy_model_pack_t *pack, const void *bytes, uint64 byte_count);
+evx_status entropy_model_pack_query_entry(const entropy_model_pack_t *pack, uint32 index, entropy_model_pack_entry_t *entry);
+evx_status entropy_model_pack_load(const entropy_model_pack_t *pack, uint32 index, entropy_coder_t *coder, 
+                                   entropy_context_t *contexts, uint32 context_count);
+
+#endif // __EVX_PACK_CABAC_H__
@@ -0,0 +1,415 @@
+
+#include "parallel_cabac.h"
+
+#if defined (EVX_PLATFORM_WINDOWS)
+    typedef HANDLE evx_thread_t;
+#else
+    #include "pthread.h"
+    typedef pthread_t evx_thread_t;
+#endif
+
+#define EVX_PARALLEL_HEADER_BITS            (192)
+#define EVX_PARALLEL_ENTRY_BITS             (128)
+
+/*
+// Job Queue
+//
+// Workers claim job indices from a shared counter until the queue is empty,
+// so chunks of uneven cost balance across the pool without any locking. The 
+// calling thread works alongside the pool, and if a worker cannot be started
+// the remaining workers simply pick up its share.
+*/
+
+typedef void (*evx_job_function)(void *param, uint32 job_index);
+
+typedef struct
+{
+    evx_job_function function;
+    void *param;
+    uint32 job_count;
+    volatile int32 next_job;
+} evx_job_queue_t;
+
+typedef struct
+{
+    bitstream_t input;
+    bitstream_t output;
+    uint64 symbol_count;
+    evx_status status;
+} evx_parallel_chunk_t;
+
+typedef struct
+{
+    const entropy_coder_t* prototype;
+    evx_parallel_chunk_t *chunks;
+} evx_parallel_batch_t;
+
+uint32 evx_query_processor_count()
+{
+#if defined (EVX_PLATFORM_WINDOWS)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return evx_max2(info.dwNumberOfProcessors, 1);
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (uint32) count : 1;
+#endif
+}
+
+static uint32 evx_job_queue_acquire(evx_job_queue_t *queue)
+{
+#if defined (EVX_PLATFORM_WINDOWS)
+    return (uint32) (InterlockedIncrement((volatile LONG *) &queue->next_job) - 1);
+#else
+    return (uint32) __sync_fetch_and_add(&queue->next_job, 1);
+#endif
+}
+
+static void evx_job_queue_drain(evx_job_queue_t *queue)
+{
+    uint32 job_index = 0;
+
+    while ((job_index = evx_job_queue_acquire(queue)) < queue->job_count)
+    {
+        queue->function(queue->param, job_index);
+    }
+}
+
+#if defined (EVX_PLATFORM_WINDOWS)
+static DWORD WINAPI evx_job_worker(LPVOID param)
+{
+    evx_job_queue_drain((evx_job_queue_t *) param);
+    return 0;
+}
+#else
+static void *evx_job_worker(void *param)
+{
+    evx_job_queue_drain((evx_job_queue_t *) param);
+    return 0;
+}
+#endif
+
+static void evx_run_jobs(evx_job_function function, void *param, uint32 job_count, uint32 thread_count)
+{
+    evx_thread_t threads[EVX_PARALLEL_MAX_THREADS];
+    evx_job_queue_t queue;
+    uint32 spawned = 0;
+
+    queue.function = function;
+    queue.param = param;
+    queue.job_count = job_count;
+    queue.next_job = 0;
+
+    if (0 == thread_count)
+    {
+        thread_count = evx_query_processor_count();
+    }
+
+    thread_count = evx_min2(evx_min2(thread_count, job_count), EVX_PARALLEL_MAX_THREADS);
+
+    /* The calling thread is the last member of the pool. */
+    for (; spawned + 1 < thread_count; ++spawned)
+    {
+#if defined (EVX_PLATFORM_WINDOWS)
+        threads[spawned] = CreateThread(NULL, 0, evx_job_worker, &queue, 0, NULL);
+
+        if (!threads[spawned])
+        {
+            break;
+        }
+#else
+        if (0 != pthread_create(&threads[spawned], NULL, evx_job_worker, &queue))
+        {
+            break;
+        }
+#endif
+    }
+
+    evx_job_queue_drain(&queue);
+
+    for (uint32 i = 0; i < spawned; ++i)
+    {
+#if defined (EVX_PLATFORM_WINDOWS)
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+}
+
+static void evx_parallel_refer_range(bitstream_t *view, const bitstream_t *source, uint64 start, uint64 end)
+{
+    /* A read only window onto part of the source. It never owns the buffer. */
+    *view = *source;
+    view->read_index = start;
+    view->write_index = end;
+    view->growable = 0;
+    view->ownership = EVX_BITSTREAM_BORROWED;
+}
+
+static void evx_parallel_encode_chunk(void *param, uint32 job_index)
+{
+    evx_parallel_batch_t *batch = (evx_parallel_batch_t *) param;
+    evx_parallel_chunk_t *chunk = &batch->chunks[job_index];
+    entropy_coder_t coder = *batch->prototype;
+
+    bitstream_create_init(&chunk->output);
+    bitstream_set_growth(&chunk->output, 1);
+    chunk->status = bitstream_reserve(&chunk->output, entropy_coder_query_encode_bound(&coder, chunk->symbol_count));
+
+    if (EVX_SUCCESS == chunk->status)
+    {
+        chunk->status = entropy_coder_encode(&coder, &chunk->input, &chunk->output);
+    }
+}
+
+static void evx_parallel_decode_chunk(void *param, uint32 job_index)
+{
+    evx_parallel_batch_t *batch = (evx_parallel_batch_t *) param;
+    evx_parallel_chunk_t *chunk = &batch->chunks[job_index];
+    entropy_coder_t coder = *batch->prototype;
+
+    bitstream_create_init(&chunk->output);
+    bitstream_set_growth(&chunk->output, 1);
+    chunk->status = bitstream_reserve(&chunk->output, chunk->symbol_count);
+
+    if (EVX_SUCCESS == chunk->status)
+    {
+        chunk->status = entropy_coder_decode(&coder, chunk->symbol_count, &chunk->input, &chunk->output);
+    }
+}
+
+static void evx_parallel_free_chunks(evx_parallel_chunk_t *chunks, uint32 chunk_count)
+{
+    for (uint32 i = 0; i < chunk_count; ++i)
+    {
+        bitstream_clear(&chunks[i].output);
+    }
+
+    free(chunks);
+}
+
+static evx_status evx_parallel_put_uint64(bitstream_writer_t *writer, uint64 value)
+{
+    if (EVX_SUCCESS != bitstream_writer_put_bits(writer, (uint32) value, 32) ||
+        EVX_SUCCESS != bitstream_writer_put_bits(writer, (uint32) (value >> 32), 32))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    return EVX_SUCCESS;
+}
+
+static uint32 evx_parallel_get_uint32(bitstream_reader_t *reader)
+{
+    uint32 value = bitstream_reader_peek(reader, 32);
+    bitstream_reader_consume(reader, 32);
+    return value;
+}
+
+static uint64 evx_parallel_get_uint64(bitstream_reader_t *reader)
+{
+    uint64 low = evx_parallel_get_uint32(reader);
+    return low | ((uint64) evx_parallel_get_uint32(reader) << 32);
+}
+
+evx_status entropy_coder_encode_parallel(const entropy_coder_t* prototype, bitstream_t *source, bitstream_t *dest, uint64 chunk_bits, uint32 thread_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!prototype || !source || !dest || 0 == chunk_bits) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    uint64 symbol_count = bitstream_query_occupancy(source);
+    uint64 chunk_count = (symbol_count + chunk_bits - 1) / chunk_bits;
+
+    if (chunk_count > EVX_MAX_UINT32)
+    {
+        return evx_post_error(EVX_ERROR_INVALIDARG);
+    }
+
+    evx_parallel_chunk_t *chunks = (evx_parallel_chunk_t *) calloc(evx_max2(chunk_count, 1), sizeof(evx_parallel_chunk_t));
+
+    if (!chunks)
+    {
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    for (uint64 i = 0; i < chunk_count; ++i)
+    {
+        uint64 start = source->read_index + i * chunk_bits;
+        chunks[i].symbol_count = evx_min2(chunk_bits, source->write_index - start);
+        evx_parallel_refer_range(&chunks[i].input, source, start, start + chunks[i].symbol_count);
+    }
+
+    evx_parallel_batch_t batch = { prototype, chunks };
+    evx_run_jobs(evx_parallel_encode_chunk, &batch, (uint32) chunk_count, thread_count);
+
+    uint64 payload_bits = 0;
+
+    for (uint64 i = 0; i < chunk_count; ++i)
+    {
+        if (EVX_SUCCESS != chunks[i].status)
+        {
+            evx_parallel_free_chunks(chunks, (uint32) chunk_count);
+            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+        }
+
+        payload_bits += chunks[i].output.write_index;
+    }
+
+    /* Emit the header and chunk table, then append each codeword in order. */
+    evx_status result = bitstream_reserve(dest, EVX_PARALLEL_HEADER_BITS + chunk_count * EVX_PARALLEL_ENTRY_BITS + payload_bits);
+
+    if (EVX_SUCCESS == result)
+    {
+        bitstream_writer_t writer;
+        uint64 offset = 0;
+
+        bitstream_writer_attach(&writer, dest);
+
+        if (EVX_SUCCESS != bitstream_writer_put_bits(&writer, EVX_PARALLEL_MAGIC, 32) ||
+            EVX_SUCCESS != bitstream_writer_put_bits(&writer, (uint32) chunk_count, 32) ||
+            EVX_SUCCESS != evx_parallel_put_uint64(&writer, chunk_bits) ||
+            EVX_SUCCESS != evx_parallel_put_uint64(&writer, payload_bits))
+        {
+            result = EVX_ERROR_CAPACITY_LIMIT;
+        }
+
+        for (uint64 i = 0; i < chunk_count && EVX_SUCCESS == result; ++i)
+        {
+            if (EVX_SUCCESS != evx_parallel_put_uint64(&writer, offset) ||
+                EVX_SUCCESS != evx_parallel_put_uint64(&writer, chunks[i].symbol_count))
+            {
+                result = EVX_ERROR_CAPACITY_LIMIT;
+            }
+
+            offset += chunks[i].output.write_index;
+        }
+
+        if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+        {
+            result = EVX_ERROR_CAPACITY_LIMIT;
+        }
+    }
+
+    for (uint64 i = 0; i < chunk_count && EVX_SUCCESS == result; ++i)
+    {
+        result = bitstream_write_bits(dest, chunks[i].output.data_store, chunks[i].output.write_index);
+    }
+
+    evx_parallel_free_chunks(chunks, (uint32) chunk_count);
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    source->read_index = source->write_index;
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_decode_parallel(const entropy_coder_t* prototype, bitstream_t *source, bitstream_t *dest, uint32 thread_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!prototype || !source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (bitstream_query_occupancy(source) < EVX_PARALLEL_HEADER_BITS)
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    bitstream_reader_t reader;
+    bitstream_reader_attach(&reader, source);
+
+    uint32 magic = evx_parallel_get_uint32(&reader);
+    uint32 chunk_count = evx_parallel_get_uint32(&reader);
+    uint64 chunk_bits = evx_parallel_get_uint64(&reader);
+    uint64 payload_bits = evx_parallel_get_uint64(&reader);
+    uint64 table_bits = (uint64) chunk_count * EVX_PARALLEL_ENTRY_BITS;
+    uint64 available = bitstream_query_occupancy(source) - EVX_PARALLEL_HEADER_BITS;
+
+    if (EVX_PARALLEL_MAGIC != magic || 0 == chunk_bits || table_bits > available || payload_bits > available - table_bits)
+    {
+        bitstream_reader_detach(&reader);
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    evx_parallel_chunk_t *chunks = (evx_parallel_chunk_t *) calloc(evx_max2(chunk_count, 1), sizeof(evx_parallel_chunk_t));
+
+    if (!chunks)
+    {
+        bitstream_reader_detach(&reader);
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    uint64 payload_start = source->read_index + EVX_PARALLEL_HEADER_BITS + table_bits;
+    uint64 previous = 0;
+    evx_status result = EVX_SUCCESS;
+
+    for (uint32 i = 0; i < chunk_count; ++i)
+    {
+        uint64 offset = evx_parallel_get_uint64(&reader);
+        chunks[i].symbol_count = evx_parallel_get_uint64(&reader);
+
+        /* Each chunk ends where the next one begins. Reject tables that are not
+           ordered or that step outside the payload. */
+        if (offset < previous || offset > payload_bits || 0 == chunks[i].symbol_count || chunks[i].symbol_count > chunk_bits)
+        {
+            result = EVX_ERROR_INVALID_RESOURCE;
+            break;
+        }
+
+        evx_parallel_refer_range(&chunks[i].input, source, payload_start + offset, payload_start + payload_bits);
+
+        if (i)
+        {
+            chunks[i - 1].input.write_index = payload_start + offset;
+        }
+
+        previous = offset;
+    }
+
+    bitstream_reader_detach(&reader);
+
+    if (EVX_SUCCESS != result)
+    {
+        free(chunks);
+        return evx_post_error(result);
+    }
+
+    evx_parallel_batch_t batch = { prototype, chunks };
+    evx_run_jobs(evx_parallel_decode_chunk, &batch, chunk_count, thread_count);
+
+    for (uint32 i = 0; i < chunk_count && EVX_SUCCESS == result; ++i)
+    {
+        if (EVX_SUCCESS != chunks[i].status)
+        {
+            result = EVX_ERROR_EXECUTION_FAILURE;
+            break;
+        }
+
+        result = bitstream_write_bits(dest, chunks[i].output.data_store, chunks[i].symbol_count);
+    }
+
+    evx_parallel_free_chunks(chunks, chunk_count);
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(result);
+    }
+
+    source->read_index = payload_start + payload_bits;
+
+    return EVX_SUCCESS;
+}
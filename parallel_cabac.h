@@ -0,0 +1,74 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// parallel_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_PARALLEL_CABAC_H__
+#define __EVX_PARALLEL_CABAC_H__
+
+#include "cabac.h"
+
+#define EVX_PARALLEL_MAGIC                  (0x50585645)      // 'EVXP'
+#define EVX_PARALLEL_DEFAULT_CHUNK_BITS     (8 * EVX_MB)
+#define EVX_PARALLEL_MAX_THREADS            (256)
+
+/*
+// Parallel Coding
+//
+// entropy_coder_encode_parallel splits the source into chunks of chunk_bits 
+// symbols and codes each chunk as an independent codeword on a pool of worker
+// threads. Every chunk starts from a copy of the prototype coder, so the 
+// prototype must be freshly initialized (init1/2/3 and select_engine) and is
+// not modified. Models restart at each chunk boundary, which costs a little 
+// ratio; larger chunks cost less but expose less parallelism.
+//
+// The output is a container that starts at the destination's write index:
+//
+//   uint32   magic (EVX_PARALLEL_MAGIC)
+//   uint32   chunk count
+//   uint64   symbols per chunk
+//   uint64   payload size in bits
+//   {uint64 payload bit offset, uint64 symbol count} per chunk
+//   payload  the concatenated chunk codewords
+//
+// All fields are little endian and all offsets are relative to the start of
+// the payload, so the decoder can hand every chunk to a different thread. 
+// entropy_coder_decode_parallel must be given a prototype configured the same 
+// way as the one used to encode. A thread_count of zero uses every processor.
+*/
+
+uint32 evx_query_processor_count();
+
+evx_status entropy_coder_encode_parallel(const entropy_coder_t* prototype, bitstream_t *source, bitstream_t *dest, uint64 chunk_bits, uint32 thread_count);
+evx_status entropy_coder_decode_parallel(const entropy_coder_t* prototype, bitstream_t *source, bitstream_t *dest, uint32 thread_count);
+
+#endif // __EVX_PARALLEL_CABAC_H__
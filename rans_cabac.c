@@ -0,0 +1,203 @@
+
+#include "rans_cabac.h"
+
+/* A state at or above this bound times the frequency of the next symbol must 
+   shed a word before the symbol is coded, or it would leave the valid range. */
+#define EVX_RANS_ENCODE_BOUND               ((EVX_RANS_STATE_LOW >> EVX_ENTROPY_PROBABILITY_BITS) << EVX_RANS_WORD_BITS)
+
+static evx_status entropy_coder_write_rans_block(uint64 state, const uint32 *words, uint64 word_count, bitstream_writer_t *writer)
+{
+    /* The decoder starts from the final state and consumes the words in the 
+       reverse of the order in which they were produced. */
+    if (EVX_SUCCESS != bitstream_writer_put_bits(writer, (uint32) state, 32) ||
+        EVX_SUCCESS != bitstream_writer_put_bits(writer, (uint32) (state >> 32), 32))
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    for (uint64 i = word_count; i > 0; --i)
+    {
+        if (EVX_SUCCESS != bitstream_writer_put_bits(writer, words[i - 1], EVX_RANS_WORD_BITS))
+        {
+            return EVX_ERROR_CAPACITY_LIMIT;
+        }
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_encode_rans(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    uint64 remaining = bitstream_query_occupancy(source);
+    uint64 block_bins = evx_max2(evx_min2(remaining, EVX_RANS_BLOCK_BINS), 1);
+
+    /* Every bin sheds at most one word, so a block never needs more words than
+       it has bins. */
+    uint16 *probabilities = (uint16 *) malloc(block_bins * sizeof(uint16));
+    uint32 *values = (uint32 *) malloc(((block_bins + 31) >> 5) * sizeof(uint32));
+    uint32 *words = (uint32 *) malloc(block_bins * sizeof(uint32));
+
+    if (!probabilities || !values || !words)
+    {
+        free(probabilities);
+        free(values);
+        free(words);
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    evx_status result = EVX_SUCCESS;
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+
+    while (remaining && EVX_SUCCESS == result)
+    {
+        uint64 count = evx_min2(remaining, block_bins);
+        uint64 state = EVX_RANS_STATE_LOW;
+        uint64 word_count = 0;
+
+        /* Forward pass: resolve and update the model in decode order. */
+        for (uint64 i = 0; i < count; i += 32)
+        {
+            uint8 chunk = (uint8) evx_min2(count - i, 32);
+            uint32 bits = bitstream_reader_peek(&reader, chunk);
+            bitstream_reader_consume(&reader, chunk);
+            values[i >> 5] = bits;
+
+            for (uint8 j = 0; j < chunk; ++j, bits >>= 1)
+            {
+                probabilities[i + j] = (uint16) entropy_coder_query_probability(coder);
+                entropy_coder_update_model(coder, bits & 0x1);
+            }
+        }
+
+        /* Backward pass: code the block last bin first. */
+        for (uint64 i = count; i > 0; --i)
+        {
+            uint32 probability = probabilities[i - 1];
+            uint8 bit = (values[(i - 1) >> 5] >> ((i - 1) & 31)) & 0x1;
+            uint32 frequency = bit ? EVX_ENTROPY_PROBABILITY_ONE - probability : probability;
+            uint32 start = bit ? probability : 0;
+
+            if (state >= EVX_RANS_ENCODE_BOUND * frequency)
+            {
+                words[word_count++] = (uint32) state;
+                state >>= EVX_RANS_WORD_BITS;
+            }
+
+            state = ((state / frequency) << EVX_ENTROPY_PROBABILITY_BITS) + (state % frequency) + start;
+        }
+
+        result = entropy_coder_write_rans_block(state, words, word_count, &writer);
+        remaining -= count;
+    }
+
+    bitstream_reader_detach(&reader);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        result = EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    free(probabilities);
+    free(values);
+    free(words);
+    entropy_coder_clear(coder);
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_CAPACITY_LIMIT);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_coder_decode_rans(entropy_coder_t* coder, uint64 symbol_count, bitstream_t *source, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || 0 == symbol_count || !source || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    bitstream_reader_t reader;
+    bitstream_writer_t writer;
+    bitstream_reader_attach(&reader, source);
+    bitstream_writer_attach(&writer, dest);
+    entropy_coder_clear(coder);
+
+    for (uint64 i = 0; i < symbol_count;)
+    {
+        uint64 block_end = evx_min2(symbol_count, i + EVX_RANS_BLOCK_BINS);
+        uint64 state = bitstream_reader_peek(&reader, 32);
+        bitstream_reader_consume(&reader, 32);
+        state |= (uint64) bitstream_reader_peek(&reader, 32) << 32;
+        bitstream_reader_consume(&reader, 32);
+
+        while (i < block_end)
+        {
+            uint8 count = (uint8) evx_min2(block_end - i, 32);
+            uint32 bits = 0;
+
+            for (uint8 j = 0; j < count; ++j)
+            {
+                uint32 probability = (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive) ? coder->model : entropy_coder_query_probability(coder);
+                uint32 slot = (uint32) state & (EVX_ENTROPY_PROBABILITY_ONE - 1);
+                uint8 bit = slot >= probability;
+                uint32 mask = 0 - (uint32) bit;
+
+                /* Select the symbol's frequency and start without a branch. */
+                uint32 frequency = probability + ((EVX_ENTROPY_PROBABILITY_ONE - probability - probability) & mask);
+                state = frequency * (state >> EVX_ENTROPY_PROBABILITY_BITS) + slot - (probability & mask);
+
+                if (state < EVX_RANS_STATE_LOW)
+                {
+                    state = (state << EVX_RANS_WORD_BITS) | bitstream_reader_peek(&reader, EVX_RANS_WORD_BITS);
+                    bitstream_reader_consume(&reader, EVX_RANS_WORD_BITS);
+                }
+
+                if (EVX_ENTROPY_MODEL_SHIFT == coder->adaptive)
+                {
+                    uint32 zero = probability + ((EVX_ENTROPY_PROBABILITY_ONE - probability) >> coder->rate);
+                    uint32 one = probability - (probability >> coder->rate);
+                    coder->model = zero + ((one - zero) & mask);
+                }
+                else
+                {
+                    entropy_coder_update_model(coder, bit);
+                }
+
+                bits |= (uint32) bit << j;
+            }
+
+            if (EVX_SUCCESS != bitstream_writer_put_bits(&writer, bits, count))
+            {
+                bitstream_reader_detach(&reader);
+                bitstream_writer_detach(&writer);
+                return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+            }
+
+            i += count;
+        }
+    }
+
+    bitstream_reader_detach(&reader);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer))
+    {
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    return EVX_SUCCESS;
+}
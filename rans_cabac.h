@@ -0,0 +1,69 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// rans_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_RANS_CABAC_H__
+#define __EVX_RANS_CABAC_H__
+
+#include "cabac.h"
+
+/* The state is kept in [EVX_RANS_STATE_LOW, EVX_RANS_STATE_LOW << 32) and is
+   renormalized 32 bits at a time. A state far wider than the 16 bit 
+   probabilities keeps the rounding loss negligible. */
+#define EVX_RANS_STATE_LOW                  ((uint64)0x1 << 31)
+#define EVX_RANS_STATE_BITS                 (64)
+#define EVX_RANS_WORD_BITS                  (32)
+
+/* Bins are buffered and encoded in reverse one block at a time. Each block is
+   a self-contained rANS codeword (its final state followed by its words) so 
+   the encoder's memory stays bounded for streams of any length. */
+#define EVX_RANS_BLOCK_BINS                 (1 * EVX_MB)
+
+/*
+// rANS Engine
+//
+// EVX_ENTROPY_ENGINE_RANS replaces interval splitting with a binary rANS 
+// coder. A zero occupies the first P(0) slots of the 2^16 slot alphabet and a
+// one occupies the rest, so decoding a bin takes one multiply, one compare and
+// a refill when the state drops below EVX_RANS_STATE_LOW.
+//
+// rANS decodes in the reverse order of encoding. The encoder resolves the 
+// model forward, buffers the probability of every bin in the block and then 
+// codes the block backwards, so the decoder runs forward with the same model
+// updates. Callers keep using entropy_coder_encode and entropy_coder_decode.
+*/
+
+evx_status entropy_coder_encode_rans(entropy_coder_t* coder, bitstream_t *source, bitstream_t *dest);
+evx_status entropy_coder_decode_rans(entropy_coder_t* coder, uint64 symbol_count, bitstream_t *source, bitstream_t *dest);
+
+#endif // __EVX_RANS_CABAC_H__
@@ -0,0 +1,110 @@
+
+#include "rate_cabac.h"
+
+/* log2(1 + i / EVX_RATE_TABLE_SIZE) in EVX_RATE_FRACTION_BITS fixed point. The
+   extra entry at the end is the upper bound of the final interval. */
+static const uint16 evx_rate_log2_table[EVX_RATE_TABLE_SIZE + 1] = 
+{
+    0x0000, 0x00B8, 0x0170, 0x0227, 0x02DD, 0x0392, 0x0447, 0x04FB, 0x05AF, 0x0661,
+    0x0713, 0x07C5, 0x0876, 0x0926, 0x09D5, 0x0A84, 0x0B32, 0x0BDF, 0x0C8C, 0x0D39,
+    0x0DE4, 0x0E8F, 0x0F39, 0x0FE3, 0x108C, 0x1135, 0x11DD, 0x1284, 0x132B, 0x13D1,
+    0x1477, 0x151C, 0x15C0, 0x1664, 0x1707, 0x17AA, 0x184C, 0x18EE, 0x198F, 0x1A2F,
+    0x1ACF, 0x1B6F, 0x1C0E, 0x1CAC, 0x1D4A, 0x1DE7, 0x1E84, 0x1F20, 0x1FBC, 0x2057,
+    0x20F2, 0x218C, 0x2226, 0x22BF, 0x2358, 0x23F0, 0x2488, 0x251F, 0x25B6, 0x264C,
+    0x26E2, 0x2778, 0x280D, 0x28A1, 0x2935, 0x29C8, 0x2A5B, 0x2AEE, 0x2B80, 0x2C12,
+    0x2CA3, 0x2D34, 0x2DC4, 0x2E54, 0x2EE4, 0x2F73, 0x3001, 0x308F, 0x311D, 0x31AB,
+    0x3237, 0x32C4, 0x3350, 0x33DC, 0x3467, 0x34F2, 0x357C, 0x3606, 0x3690, 0x3719,
+    0x37A2, 0x382A, 0x38B2, 0x393A, 0x39C1, 0x3A48, 0x3ACF, 0x3B55, 0x3BDA, 0x3C60,
+    0x3CE5, 0x3D69, 0x3DEE, 0x3E72, 0x3EF5, 0x3F78, 0x3FFB, 0x407D, 0x40FF, 0x4181,
+    0x4202, 0x4283, 0x4304, 0x4384, 0x4404, 0x4484, 0x4503, 0x4582, 0x4601, 0x467F,
+    0x46FD, 0x477A, 0x47F8, 0x4874, 0x48F1, 0x496D, 0x49E9, 0x4A65, 0x4AE0, 0x4B5B,
+    0x4BD6, 0x4C50, 0x4CCA, 0x4D44, 0x4DBD, 0x4E36, 0x4EAF, 0x4F27, 0x4F9F, 0x5017,
+    0x508F, 0x5106, 0x517D, 0x51F4, 0x526A, 0x52E0, 0x5356, 0x53CB, 0x5440, 0x54B5,
+    0x552A, 0x559E, 0x5612, 0x5686, 0x56F9, 0x576C, 0x57DF, 0x5852, 0x58C4, 0x5936,
+    0x59A8, 0x5A1A, 0x5A8B, 0x5AFC, 0x5B6C, 0x5BDD, 0x5C4D, 0x5CBD, 0x5D2C, 0x5D9C,
+    0x5E0B, 0x5E7A, 0x5EE8, 0x5F57, 0x5FC5, 0x6033, 0x60A0, 0x610D, 0x617B, 0x61E7,
+    0x6254, 0x62C0, 0x632C, 0x6398, 0x6404, 0x646F, 0x64DA, 0x6545, 0x65AF, 0x661A,
+    0x6684, 0x66EE, 0x6757, 0x67C1, 0x682A, 0x6893, 0x68FC, 0x6964, 0x69CC, 0x6A34,
+    0x6A9C, 0x6B04, 0x6B6B, 0x6BD2, 0x6C39, 0x6CA0, 0x6D06, 0x6D6C, 0x6DD2, 0x6E38,
+    0x6E9E, 0x6F03, 0x6F68, 0x6FCD, 0x7032, 0x7096, 0x70FA, 0x715E, 0x71C2, 0x7226,
+    0x7289, 0x72ED, 0x7350, 0x73B2, 0x7415, 0x7477, 0x74DA, 0x753C, 0x759D, 0x75FF,
+    0x7660, 0x76C1, 0x7722, 0x7783, 0x77E4, 0x7844, 0x78A4, 0x7904, 0x7964, 0x79C4,
+    0x7A23, 0x7A82, 0x7AE1, 0x7B40, 0x7B9F, 0x7BFD, 0x7C5C, 0x7CBA, 0x7D18, 0x7D75,
+    0x7DD3, 0x7E30, 0x7E8D, 0x7EEA, 0x7F47, 0x7FA4, 0x8000
+};
+
+uint32 entropy_rate_query_cost(uint32 probability)
+{
+    probability = evx_max2(1, evx_min2(probability, EVX_ENTROPY_PROBABILITY_ONE));
+
+    /* Normalize the probability so that its leading one sits at bit 31. The 
+       bits that follow it index and weight the fractional log2 table. */
+    uint8 exponent = log2_32(probability);
+    uint32 mantissa = probability << (31 - exponent);
+    uint32 index = (mantissa >> (31 - EVX_RATE_TABLE_BITS)) & (EVX_RATE_TABLE_SIZE - 1);
+    uint32 weight = (mantissa >> (31 - EVX_RATE_TABLE_BITS - EVX_RATE_WEIGHT_BITS)) & ((0x1 << EVX_RATE_WEIGHT_BITS) - 1);
+
+    uint32 lower = evx_rate_log2_table[index];
+    uint32 upper = evx_rate_log2_table[index + 1];
+    uint32 fraction = lower + (((upper - lower) * weight + (0x1 << (EVX_RATE_WEIGHT_BITS - 1))) >> EVX_RATE_WEIGHT_BITS);
+
+    /* -log2(p / ONE) = PROBABILITY_BITS - log2(p) */
+    return ((uint32) (EVX_ENTROPY_PROBABILITY_BITS - exponent) << EVX_RATE_FRACTION_BITS) - fraction;
+}
+
+uint32 entropy_coder_estimate_bits(const entropy_coder_t* coder, uint8 value)
+{
+    uint32 probability = entropy_coder_query_probability(coder);
+
+    if (value & 0x1)
+    {
+        probability = EVX_ENTROPY_PROBABILITY_ONE - probability;
+    }
+
+    return entropy_rate_query_cost(probability);
+}
+
+uint32 entropy_context_estimate_bits(entropy_context_t context, uint8 value)
+{
+    uint32 probability = context;
+
+    if (value & 0x1)
+    {
+        probability = EVX_ENTROPY_PROBABILITY_ONE - probability;
+    }
+
+    return entropy_rate_query_cost(probability);
+}
+
+evx_status entropy_coder_estimate_stream(const entropy_coder_t* coder, const bitstream_t *source, uint64 *cost)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!coder || !source || !cost) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    /* Adapt a copy of the model and read through a copy of the stream so that
+       neither the caller's coder nor its source is modified. */
+    entropy_coder_t model = *coder;
+    bitstream_t view = *source;
+    bitstream_reader_t reader;
+    uint64 bit_count = bitstream_query_occupancy(&view);
+    uint64 total = 0;
+
+    bitstream_reader_attach(&reader, &view);
+
+    for (uint64 i = 0; i < bit_count; ++i)
+    {
+        uint8 value = bitstream_reader_read_bit(&reader);
+        total += entropy_coder_estimate_bits(&model, value);
+        entropy_coder_update_model(&model, value);
+    }
+
+    bitstream_reader_detach(&reader);
+    *cost = total;
+
+    return EVX_SUCCESS;
+}
@@ -0,0 +1,85 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// rate_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_RATE_CABAC_H__
+#define __EVX_RATE_CABAC_H__
+
+#include "cabac.h"
+
+/* Costs are fixed point bits with EVX_RATE_FRACTION_BITS fractional bits. */
+#define EVX_RATE_FRACTION_BITS              (15)
+#define EVX_RATE_ONE_BIT                    ((uint32) 0x1 << EVX_RATE_FRACTION_BITS)
+
+/* The fractional part of log2 is tabulated over the top EVX_RATE_TABLE_BITS
+   bits of the normalized probability and interpolated over the next 
+   EVX_RATE_WEIGHT_BITS, which keeps the error below 1/10000th of a bit. */
+#define EVX_RATE_TABLE_BITS                 (8)
+#define EVX_RATE_TABLE_SIZE                 ((uint32) 0x1 << EVX_RATE_TABLE_BITS)
+#define EVX_RATE_WEIGHT_BITS                (8)
+
+/*
+// Rate Estimation
+//
+// Estimates what bins would cost without coding them, so that encoders can
+// cost candidate decisions (modes, binarizations, formats) without running a
+// trial encode. The cost of a bin is -log2(p) of the probability the coder 
+// would assign it, which the arithmetic and range engines approach to within 
+// a small fraction of a bit per bin.
+//
+// The cost of a probability is split into the integer part, found with
+// log2_32, and a fractional part read from a table indexed by the normalized
+// probability. Costs are returned in 1/EVX_RATE_ONE_BIT units so that sums
+// over many bins do not accumulate rounding error.
+//
+// entropy_coder_estimate_bits costs a single bin against the coder's current
+// model and works for every model and engine. entropy_context_estimate_bits 
+// does the same for a context of a context coding session.
+//
+// entropy_coder_estimate_stream costs every bit of a bitstream as 
+// entropy_coder_encode would code it, including model adaptation after each 
+// bin. It works on a copy of the model, so neither the coder nor the source 
+// is modified and the same coder can cost several candidates in turn.
+//
+// The estimates exclude the few bytes an encoder spends on flushing. Use 
+// entropy_coder_query_encode_bound to size buffers.
+*/
+
+uint32 entropy_rate_query_cost(uint32 probability);
+
+uint32 entropy_coder_estimate_bits(const entropy_coder_t* coder, uint8 value);
+uint32 entropy_context_estimate_bits(entropy_context_t context, uint8 value);
+
+evx_status entropy_coder_estimate_stream(const entropy_coder_t* coder, const bitstream_t *source, uint64 *cost);
+
+#endif // __EVX_RATE_CABAC_H__
@@ -0,0 +1,383 @@
+
+#include "stream_cabac.h"
+
+static evx_status entropy_stream_emit(void *param, const uint8 *data, uint64 byte_count)
+{
+    entropy_stream_encoder_t* stream = (entropy_stream_encoder_t *) param;
+
+    if (EVX_SUCCESS != stream->sink(stream->sink_param, data, byte_count))
+    {
+        return evx_post_error(EVX_ERROR_IO_FAILURE);
+    }
+
+    stream->bytes_emitted += byte_count;
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_stream_start_encode(entropy_stream_encoder_t* stream, entropy_coder_t* coder, bitstream_sink_t sink, void *param, uint32 buffer_bytes)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!stream || !coder || !sink) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (0 == buffer_bytes)
+    {
+        buffer_bytes = EVX_STREAM_BUFFER_BYTES_DEFAULT;
+    }
+
+    /* The buffer must hold one cache word plus the bytes stored on detach. */
+    buffer_bytes = evx_max2(buffer_bytes, EVX_STREAM_BUFFER_BYTES_MIN);
+
+    stream->coder = coder;
+    stream->sink = sink;
+    stream->sink_param = param;
+    stream->bytes_emitted = 0;
+
+    bitstream_create_init(&stream->buffer);
+
+    if (((uint64) buffer_bytes << 3) != bitstream_resize_capacity(&stream->buffer, (uint64) buffer_bytes << 3))
+    {
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    if (EVX_SUCCESS != entropy_coder_start_encode(coder, &stream->buffer))
+    {
+        bitstream_clear(&stream->buffer);
+        return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+    }
+
+    bitstream_writer_set_sink(&coder->writer, entropy_stream_emit, stream);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_stream_encode(entropy_stream_encoder_t* stream, bitstream_t *source)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!stream || !source) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    uint64 remaining = bitstream_query_occupancy(source);
+    bitstream_reader_t reader;
+    bitstream_reader_attach(&reader, source);
+
+    while (remaining) 
+    {
+        uint8 count = (uint8) evx_min2(remaining, 32);
+        uint32 bits = bitstream_reader_peek(&reader, count);
+
+        if (EVX_SUCCESS != entropy_coder_encode_bits(stream->coder, bits, count))
+        {
+            bitstream_reader_detach(&reader);
+            return evx_post_error(EVX_ERROR_IO_FAILURE);
+        }
+
+        bitstream_reader_consume(&reader, count);
+        remaining -= count;
+    }
+
+    bitstream_reader_detach(&reader);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_stream_flush(entropy_stream_encoder_t* stream)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!stream || !stream->coder->writer.stream) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    /* Bytes still held by the coder itself (the range engine's cached byte and
+       carry run, or the arithmetic engine's follow bits) are not final yet. */
+    if (EVX_SUCCESS != bitstream_writer_release(&stream->coder->writer))
+    {
+        return evx_post_error(EVX_ERROR_IO_FAILURE);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_stream_finish_encode(entropy_stream_encoder_t* stream)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!stream || !stream->coder->writer.stream) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    evx_status result = entropy_coder_finish_encode(stream->coder, &stream->buffer);
+
+    if (EVX_SUCCESS == result)
+    {
+        bitstream_t *buffer = &stream->buffer;
+        uint64 byte_count = bitstream_query_byte_occupancy(buffer);
+        uint8 partial_bits = buffer->write_index % 8;
+
+        /* The buffer is reused, so clear whatever stale bits follow the end. */
+        if (partial_bits)
+        {
+            buffer->data_store[byte_count - 1] &= (0x1 << partial_bits) - 1;
+        }
+
+        if (byte_count && EVX_SUCCESS != entropy_stream_emit(stream, buffer->data_store, byte_count))
+        {
+            result = EVX_ERROR_IO_FAILURE;
+        }
+    }
+
+    bitstream_clear(&stream->buffer);
+
+    if (EVX_SUCCESS != result)
+    {
+        return evx_post_error(EVX_ERROR_IO_FAILURE);
+    }
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_stream_start_decode(entropy_stream_decoder_t* stream, entropy_coder_t* coder, uint64 symbol_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!stream || !coder) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    if (EVX_ENTROPY_ENGINE_RANS == coder->engine)
+    {
+        return evx_post_error(EVX_ERROR_NOTIMPL);
+    }
+
+    stream->coder = coder;
+    stream->symbol_count = symbol_count;
+    stream->symbols_decoded = 0;
+    stream->primed = 0;
+    stream->input_ended = 0;
+    stream->terminated = (0 == symbol_count);
+    stream->last_block = 0;
+    stream->block_remaining = 0;
+
+    bitstream_create_init(&stream->input);
+    bitstream_set_growth(&stream->input, 1);
+
+    return EVX_SUCCESS;
+}
+
+evx_status entropy_stream_push(entropy_stream_decoder_t* stream, const void *data, uint64 byte_count)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!stream || (!data && byte_count) || stream->input_ended) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    bitstream_t *input = &stream->input;
+    uint64 consumed_bytes = input->read_index >> 3;
+
+    /* Drop the bytes that have been fully consumed so the buffer only ever holds
+       the unread tail and the new fragment. */
+    if (consumed_bytes)
+    {
+        memmove(input->data_store, &input->data_store[consumed_bytes], (size_t) ((input->write_index >> 3) - consumed_bytes));
+        input->read_index -= consumed_bytes << 3;
+        input->write_index -= consumed_bytes << 3;
+    }
+
+    if (byte_count && EVX_SUCCESS != bitstream_write_bytes(input, (void *) data, byte_count))
+    {
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    return EVX_SUCCESS;
+}
+
+void entropy_stream_end_input(entropy_stream_decoder_t* stream)
+{
+    stream->input_ended = 1;
+}
+
+static uint8 entropy_stream_is_complete(const entropy_stream_decoder_t* stream)
+{
+    if (stream->terminated)
+    {
+        return stream->last_block && !stream->block_remaining;
+    }
+
+    return stream->symbols_decoded == stream->symbol_count;
+}
+
+evx_status entropy_stream_decode(entropy_stream_decoder_t* stream, bitstream_t *dest)
+{
+    if (EVX_PARAM_CHECK) 
+    {
+        if (!stream || !dest) 
+        {
+            return evx_post_error(EVX_ERROR_INVALIDARG);
+        }
+    }
+
+    entropy_coder_t *coder = stream->coder;
+    bitstream_t *input = &stream->input;
+
+    if (entropy_stream_is_complete(stream))
+    {
+        return EVX_SUCCESS;
+    }
+
+    if (!stream->primed)
+    {
+        uint64 prime_bits = (EVX_ENTROPY_ENGINE_RANGE == coder->engine) ? (EVX_RANGE_FLUSH_BYTES << 3) : EVX_STREAM_BIN_BITS_MAX;
+
+        if (!stream->input_ended && bitstream_query_occupancy(input) < prime_bits + EVX_STREAM_BIN_BITS_MAX)
+        {
+            return EVX_ERROR_NEED_MORE_INPUT;
+        }
+
+        if (EVX_SUCCESS != entropy_coder_start_decode(coder, input))
+        {
+            return evx_post_error(EVX_ERROR_EXECUTION_FAILURE);
+        }
+
+        stream->primed = 1;
+    }
+    else
+    {
+        bitstream_reader_attach(&coder->reader, input);
+    }
+
+    bitstream_reader_t *reader = &coder->reader;
+    bitstream_writer_t writer;
+    evx_status result = EVX_SUCCESS;
+    bitstream_writer_attach(&writer, dest);
+
+    while (!entropy_stream_is_complete(stream))
+    {
+        uint64 available = reader->end_index - (reader->fill_index - reader->window_bits);
+
+        if (stream->terminated && !stream->block_remaining)
+        {
+            /* A block marker is one terminate bin and, for the last block, its 
+               length in bypass bits. Neither engine reads more than one bin's
+               worth of input for each part. */
+            if (!stream->input_ended && available < 3 * EVX_STREAM_BIN_BITS_MAX)
+            {
+                break;
+            }
+
+            stream->block_remaining = (uint64) 0x1 << EVX_ENTROPY_TERMINATE_BLOCK_BITS;
+
+            if (entropy_coder_decode_terminate(coder))
+            {
+                stream->last_block = 1;
+                stream->block_remaining = entropy_coder_decode_bypass(coder, EVX_ENTROPY_TERMINATE_BLOCK_BITS);
+            }
+
+            /* Once the input has ended a damaged stream could run on forever. */
+            if (stream->input_ended && reader->fill_index - reader->window_bits > reader->end_index + (EVX_RANGE_FLUSH_BYTES << 3) + 64)
+            {
+                result = EVX_ERROR_INVALID_RESOURCE;
+                break;
+            }
+
+            continue;
+        }
+
+        uint64 remaining = stream->terminated ? stream->block_remaining : stream->symbol_count - stream->symbols_decoded;
+        uint8 count = (uint8) evx_min2(remaining, 32);
+
+        if (!dest->growable || EVX_BITSTREAM_OWNED != dest->ownership)
+        {
+            /* Never write past a fixed destination. The caller empties it and
+               calls again to continue. */
+            uint64 space = bitstream_query_capacity(dest) - ((writer.byte_index << 3) + writer.cache_bits);
+
+            if (!space)
+            {
+                result = EVX_ERROR_CAPACITY_LIMIT;
+                break;
+            }
+
+            count = (uint8) evx_min2(count, space);
+        }
+
+        /* Decode 32 symbols at a time while the input comfortably covers them, 
+           then single symbols up to the end of the input we hold. */
+        if (!stream->input_ended && available < (uint64) count * EVX_STREAM_BIN_BITS_MAX)
+        {
+            if (available < EVX_STREAM_BIN_BITS_MAX)
+            {
+                break;
+            }
+
+            count = 1;
+        }
+
+        uint32 bits = entropy_coder_decode_bits(coder, count);
+
+        if (EVX_SUCCESS != bitstream_writer_put_bits(&writer, bits, count))
+        {
+            result = EVX_ERROR_OUTOFMEMORY;
+            break;
+        }
+
+        stream->symbols_decoded += count;
+
+        if (stream->terminated)
+        {
+            stream->block_remaining -= count;
+        }
+    }
+
+    entropy_coder_finish_decode(coder);
+
+    if (EVX_SUCCESS != bitstream_writer_detach(&writer) || EVX_ERROR_OUTOFMEMORY == result)
+    {
+        return evx_post_error(EVX_ERROR_OUTOFMEMORY);
+    }
+
+    if (EVX_ERROR_INVALID_RESOURCE == result)
+    {
+        return evx_post_error(EVX_ERROR_INVALID_RESOURCE);
+    }
+
+    if (EVX_ERROR_CAPACITY_LIMIT == result)
+    {
+        return EVX_ERROR_CAPACITY_LIMIT;
+    }
+
+    if (!entropy_stream_is_complete(stream))
+    {
+        return EVX_ERROR_NEED_MORE_INPUT;
+    }
+
+    return EVX_SUCCESS;
+}
+
+void entropy_stream_finish_decode(entropy_stream_decoder_t* stream)
+{
+    if (stream->coder->reader.stream == &stream->input)
+    {
+        entropy_coder_finish_decode(stream->coder);
+    }
+
+    bitstream_clear(&stream->input);
+}
@@ -0,0 +1,143 @@
+
+/*
+//
+// Copyright (c) 2002-2015 Joe Bertolami. All Right Reserved.
+//
+// stream_cabac.h
+//
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions are met:
+//
+//   * Redistributions of source code must retain the above copyright notice, this
+//     list of conditions and the following disclaimer.
+//
+//   * Redistributions in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+//   AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+//   IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+//   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+//   FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+//   DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+//   SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+//   CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+//   OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+//   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Additional Information:
+//
+//   For more information, visit http://www.bertolami.com.
+//
+*/
+
+#ifndef __EVX_STREAM_CABAC_H__
+#define __EVX_STREAM_CABAC_H__
+
+#include "cabac.h"
+
+#define EVX_STREAM_BUFFER_BYTES_DEFAULT     (4 * EVX_KB)
+#define EVX_STREAM_BUFFER_BYTES_MIN         (16)
+
+/* No bin of either engine consumes more than this many bits of input. */
+#define EVX_STREAM_BIN_BITS_MAX             (32)
+
+/*
+// Streaming Encoder
+//
+// A streaming encoder runs an ordinary encode session (see Context Coding in 
+// cabac.h) into a small fixed buffer and hands every output byte to a caller
+// supplied sink once the coder can no longer change it. Memory use is constant
+// regardless of the length of the stream: the arithmetic engine holds pending
+// follow bits as a count and the range engine holds its pending carry run as 
+// a count, so neither ever buffers more than buffer_bytes of output.
+//
+//  1. entropy_stream_start_encode binds a configured coder and a sink. A 
+//     buffer_bytes of zero uses EVX_STREAM_BUFFER_BYTES_DEFAULT.
+//
+//  2. Code with entropy_stream_encode, which codes source bits with the coder's
+//     own model, or with any session call on the coder itself (encode_bin, 
+//     encode_bypass, encode_bits and the binarizations in binarize_cabac.h).
+//     The sink is called whenever the buffer fills.
+//
+//  3. entropy_stream_flush hands over every byte that is final right now, for 
+//     callers that need low latency rather than large sink writes.
+//
+//  4. entropy_stream_finish_encode flushes the coder, delivers the remaining 
+//     bytes and releases the buffer. 
+//
+// The concatenation of all bytes given to the sink is identical to the output
+// of the same calls made into a single bitstream. A sink that returns an error
+// aborts the current call with EVX_ERROR_IO_FAILURE.
+*/
+
+typedef struct
+{
+  entropy_coder_t* coder;
+  bitstream_t buffer;
+  bitstream_sink_t sink;
+  void *sink_param;
+  uint64 bytes_emitted;
+} entropy_stream_encoder_t;
+
+evx_status entropy_stream_start_encode(entropy_stream_encoder_t* stream, entropy_coder_t* coder, bitstream_sink_t sink, void *param, uint32 buffer_bytes);
+evx_status entropy_stream_encode(entropy_stream_encoder_t* stream, bitstream_t *source);
+evx_status entropy_stream_flush(entropy_stream_encoder_t* stream);
+evx_status entropy_stream_finish_encode(entropy_stream_encoder_t* stream);
+
+/*
+// Streaming Decoder
+//
+// A streaming decoder accepts the codeword in fragments of any size as they
+// arrive, and decodes as far as the input it holds allows:
+//
+//  1. entropy_stream_start_decode binds a coder configured as it was for the
+//     encode, and the number of symbols to decode. A symbol_count of zero 
+//     decodes a terminated stream (see entropy_coder_encode_terminated) up 
+//     to its end marker instead.
+//
+//  2. entropy_stream_push copies a fragment into the decoder. Input that has 
+//     already been consumed is discarded, so only the unconsumed tail is held.
+//
+//  3. entropy_stream_decode appends decoded bits to dest. It returns 
+//     EVX_SUCCESS once every symbol has been decoded, or EVX_ERROR_NEED_MORE_INPUT
+//     when it has decoded all it can. Push more input and call it again; it 
+//     resumes with the next symbol. If dest has a fixed capacity and fills 
+//     up, it returns EVX_ERROR_CAPACITY_LIMIT instead; empty dest and call 
+//     again without pushing.
+//
+//  4. entropy_stream_end_input tells the decoder that no more input will come,
+//     so it may treat the rest of the codeword as zero padded just as 
+//     entropy_coder_decode does.
+//
+//  5. entropy_stream_finish_decode releases the input buffer.
+//
+// A symbol is only decoded once the decoder holds EVX_STREAM_BIN_BITS_MAX bits
+// of input beyond it, so the decoder never guesses at data that has not yet 
+// arrived. The output is identical to entropy_coder_decode regardless of how 
+// the input is split.
+*/
+
+typedef struct
+{
+  entropy_coder_t* coder;
+  bitstream_t input;
+  uint64 symbol_count;
+  uint64 symbols_decoded;
+  uint8 primed;
+  uint8 input_ended;
+
+  /* Terminated stream state. */
+  uint8 terminated;
+  uint8 last_block;
+  uint64 block_remaining;
+} entropy_stream_decoder_t;
+
+evx_status entropy_stream_start_decode(entropy_stream_decoder_t* stream, entropy_coder_t* coder, uint64 symbol_count);
+evx_status entropy_stream_push(entropy_stream_decoder_t* stream, const void *data, uint64 byte_count);
+void entropy_stream_end_input(entropy_stream_decoder_t* stream);
+evx_status entropy_stream_decode(entropy_stream_decoder_t* stream, bitstream_t *dest);
+void entropy_stream_finish_decode(entropy_stream_decoder_t* stream);
+
+#endif // __EVX_STREAM_CABAC_H__
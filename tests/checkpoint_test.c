@@ -0,0 +1,144 @@
+
+#include "cabac.h"
+
+/*
+// Decodes many checkpoint lookups from one source without touching its read 
+// index between them, and compares every bin against the original input.
+*/
+
+#define EVX_TEST_BITS                       (100003)
+#define EVX_TEST_INTERVAL                   (97)
+#define EVX_TEST_LOOKUPS                    (64)
+#define EVX_TEST_PREFIX_BITS                (3)
+
+static uint32 evx_test_state = 0x12345678;
+
+static uint32 evx_test_random()
+{
+    evx_test_state ^= evx_test_state << 13;
+    evx_test_state ^= evx_test_state >> 17;
+    evx_test_state ^= evx_test_state << 5;
+
+    return evx_test_state;
+}
+
+static uint8 evx_test_query_bit(const bitstream_t *bs, uint64 index)
+{
+    return (bs->data_store[index >> 3] >> (index & 0x7)) & 0x1;
+}
+
+static void evx_test_create_coder(entropy_coder_t *coder, uint8 engine, uint8 model)
+{
+    if (EVX_ENTROPY_MODEL_STATIC == model)
+    {
+        entropy_coder_init2(coder, 6000);
+    }
+    else if (EVX_ENTROPY_MODEL_COUNT == model)
+    {
+        entropy_coder_init1(coder);
+    }
+    else
+    {
+        entropy_coder_init3(coder, 4);
+    }
+
+    entropy_coder_select_engine(coder, engine);
+}
+
+static uint32 evx_test_run(uint8 engine, uint8 model)
+{
+    bitstream_t source, coded;
+    entropy_coder_t coder;
+    uint32 failures = 0;
+
+    bitstream_create_new(&source, EVX_TEST_BITS + 64);
+    bitstream_create_init(&coded);
+    bitstream_set_growth(&coded, 1);
+
+    for (uint64 i = 0; i < EVX_TEST_BITS; ++i)
+    {
+        bitstream_write_bit(&source, 0 == evx_test_random() % 10);
+    }
+
+    /* The codeword starts after a few unrelated bits. */
+    for (uint8 i = 0; i < EVX_TEST_PREFIX_BITS; ++i)
+    {
+        bitstream_write_bit(&coded, 1);
+    }
+
+    bitstream_t original = source;
+    uint64 checkpoint_count = entropy_coder_query_checkpoint_count(EVX_TEST_BITS, EVX_TEST_INTERVAL);
+    entropy_checkpoint_t *checkpoints = (entropy_checkpoint_t *) malloc((size_t) checkpoint_count * sizeof(entropy_checkpoint_t));
+
+    evx_test_create_coder(&coder, engine, model);
+
+    if (!checkpoints || EVX_SUCCESS != entropy_coder_encode_checkpointed(&coder, EVX_TEST_INTERVAL, &source, &coded, checkpoints, checkpoint_count))
+    {
+        free(checkpoints);
+        bitstream_clear(&source);
+        bitstream_clear(&coded);
+        return 1;
+    }
+
+    coded.read_index = EVX_TEST_PREFIX_BITS;
+
+    for (uint32 lookup = 0; lookup < EVX_TEST_LOOKUPS; ++lookup)
+    {
+        const entropy_checkpoint_t *checkpoint = &checkpoints[evx_test_random() % checkpoint_count];
+        uint64 symbol_count = evx_min2(EVX_TEST_INTERVAL, EVX_TEST_BITS - checkpoint->symbol_index);
+        bitstream_t decoded;
+
+        bitstream_create_init(&decoded);
+        bitstream_set_growth(&decoded, 1);
+        evx_test_create_coder(&coder, engine, model);
+
+        if (EVX_SUCCESS != entropy_coder_decode_checkpoint(&coder, checkpoint, symbol_count, &coded, &decoded) ||
+            EVX_TEST_PREFIX_BITS != coded.read_index)
+        {
+            ++failures;
+        }
+        else
+        {
+            for (uint64 i = 0; i < symbol_count; ++i)
+            {
+                if (evx_test_query_bit(&decoded, i) != evx_test_query_bit(&original, checkpoint->symbol_index + i))
+                {
+                    ++failures;
+                    break;
+                }
+            }
+        }
+
+        bitstream_clear(&decoded);
+    }
+
+    free(checkpoints);
+    bitstream_clear(&source);
+    bitstream_clear(&coded);
+
+    return failures;
+}
+
+int main()
+{
+    uint32 failures = 0;
+
+    for (uint8 engine = EVX_ENTROPY_ENGINE_ARITHMETIC; engine <= EVX_ENTROPY_ENGINE_RANGE; ++engine)
+    {
+        for (uint8 model = EVX_ENTROPY_MODEL_STATIC; model <= EVX_ENTROPY_MODEL_SHIFT; ++model)
+        {
+            uint32 result = evx_test_run(engine, model);
+
+            if (result)
+            {
+                printf("checkpoint_test: engine %i model %i: %u failed lookups\n", engine, model, result);
+            }
+
+            failures += result;
+        }
+    }
+
+    printf("checkpoint_test: %s\n", failures ? "FAILED" : "passed");
+
+    return failures ? 1 : 0;
+}